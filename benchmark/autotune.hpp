@@ -0,0 +1,976 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <array>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include "mtp/metaset.hpp"
+
+
+
+// recommends a metaset for the allocations recorded by mtp::export_trace
+//
+// every trace file is one phase: the peak of a size is the largest count any phase recorded for it,
+// i.e. all allocations of a phase are assumed live at its end (the allocator is reset between phases).
+// frame streams from mtp::trace_frames_open tighten that bound with the high-water mark of each traced stride;
+// without one the counts are cumulative totals, not live peaks, and are only used when allow_totals is set.
+// the observed sizes are split into at most max_defs stride ranges; every range gets the step, capacity
+// function, base block count and pivots with the fewest arena bytes that still hold the peak plus headroom
+
+class Autotuner
+{
+public:
+
+	struct Options
+	{
+		double   headroom    {0.20};
+		size_t   max_defs    {8};
+		uint32_t max_strides {256};
+		bool     page_map    {false};
+		bool     explicit_counts {false};
+		bool     allow_totals    {false};
+
+		std::string name {"tuned_set"};
+	};
+
+	struct Def
+	{
+		mtp::cfg::CapacityFunction fn {mtp::cfg::CapacityFunction::flat};
+
+		uint64_t base {0};
+		uint32_t step {0};
+
+		// explicit_counts: pivots hold the first and last stride, block_counts the traced need of each
+
+		bool explicit_counts {false};
+
+		std::vector<uint32_t> pivots;
+		std::vector<uint64_t> block_counts;
+
+		uint64_t bytes {0};
+	};
+
+	explicit Autotuner(Options options)
+		: m_options {std::move(options)}
+	{}
+
+	// a trace or frame csv, or a folder of them
+
+	bool load(const std::filesystem::path& path)
+	{
+		if (std::filesystem::is_directory(path)) {
+			std::vector<std::filesystem::path> files;
+
+			for (const auto& entry : std::filesystem::directory_iterator(path)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".csv")
+					files.push_back(entry.path());
+			}
+
+			std::sort(files.begin(), files.end());
+
+			bool loaded = false;
+			for (const auto& file : files)
+				loaded |= load_file(file);
+
+			return loaded;
+		}
+
+		return load_file(path);
+	}
+
+	bool tune()
+	{
+		build_points();
+
+		if (m_points.empty())
+			return false;
+
+		build_groups();
+		partition();
+		verify();
+
+		return !m_defs.empty();
+	}
+
+	// traced sizes sized from their cumulative count because no frame high-water mark bounds them
+
+	size_t unbounded_sizes() const
+	{
+		return static_cast<size_t>(std::count_if(m_points.begin(), m_points.end(),
+			[](const Point& point) { return !point.exact; }));
+	}
+
+	void print_report(std::ostream& out) const
+	{
+		out << "\ntraced sizes: " << m_points.size()
+			<< ", phases: " << m_phase_count
+			<< ", headroom: " << static_cast<int>(m_options.headroom * 100.0 + 0.5) << "%\n";
+
+		if (m_skipped != 0)
+			out << "skipped " << m_skipped << " sizes above the largest stride\n";
+
+		if (m_unkeyed != 0) {
+			out << "\nWARNING: " << m_unkeyed << " traced allocations overflowed the trace table and have no size;\n"
+				<< "WARNING: they are not part of the recommendation, trace fewer distinct sizes per thread\n";
+		}
+
+		if (const size_t unbounded = unbounded_sizes(); unbounded != 0) {
+			out << "\nWARNING: " << unbounded << " of " << m_points.size()
+				<< " sizes have no frame high-water bound and are sized from cumulative trace counts;\n"
+				<< "WARNING: the arena below holds every allocation ever made, not the live peak\n";
+		}
+
+		out << "\n" << std::left
+			<< std::setw(6)  << "def"
+			<< std::setw(8)  << "capf"
+			<< std::setw(12) << "base"
+			<< std::setw(10) << "step"
+			<< std::setw(24) << "strides"
+			<< "bytes\n";
+
+		out << std::string(6 + 8 + 12 + 10 + 24 + 14, '-') << "\n";
+
+		uint64_t total = 0;
+
+		for (size_t i = 0; i < m_defs.size(); ++i) {
+			const Def& def = m_defs[i];
+
+			std::ostringstream range;
+			range << def.pivots.front() << " - " << def.pivots.back()
+				<< " (" << def.block_counts.size() << ")";
+
+			out << std::left
+				<< std::setw(6)  << i
+				<< std::setw(8)  << (def.explicit_counts ? "expl" : capf_name(def.fn))
+				<< std::setw(12) << def.base
+				<< std::setw(10) << def.step
+				<< std::setw(24) << range.str()
+				<< format_bytes(def.bytes) << "\n";
+
+			total += def.bytes;
+		}
+
+		out << "\narena bytes: " << format_bytes(total) << "\n";
+
+		if (total > mtp::cfg::max_arena_size)
+			out << "warning: above the " << format_bytes(mtp::cfg::max_arena_size) << " arena limit of a metaset\n";
+
+		if (m_traced_bytes != 0)
+			out << "traced set, used strides only: " << format_bytes(m_traced_bytes) << "\n";
+
+		out << std::endl;
+	}
+
+	void write_header(std::ostream& out, std::string_view sources) const
+	{
+		uint64_t total = 0;
+		for (const Def& def : m_defs)
+			total += def.bytes;
+
+		out << "#pragma once\n\n"
+			<< "// generated by mtp_autotune from " << sources << "\n"
+			<< "// headroom " << static_cast<int>(m_options.headroom * 100.0 + 0.5) << "%, "
+			<< "arena " << format_bytes(total) << " per allocator\n";
+
+		if (const size_t unbounded = unbounded_sizes(); unbounded != 0)
+			out << "// WARNING: " << unbounded << " sizes sized from cumulative trace counts, no frame high-water bound\n";
+
+		out << "\n#include \"mtp_memory.hpp\"\n\n\n";
+
+		if (m_options.page_map)
+			out << "using " << m_options.name << " = mtp::metaset_with <\n\n"
+				<< "\tmtp::set_options{.block_header = mtp::header::page_map},\n\n";
+		else
+			out << "using " << m_options.name << " = mtp::metaset <\n\n";
+
+		for (size_t i = 0; i < m_defs.size(); ++i) {
+			const Def& def = m_defs[i];
+
+			if (def.explicit_counts) {
+				out << "\tmtp::def_explicit<" << def.step << ", " << def.pivots.front() << ", " << def.pivots.back();
+
+				for (uint64_t count : def.block_counts)
+					out << ", " << count;
+
+				out << ">" << (i + 1 < m_defs.size() ? "," : "") << "\n";
+				continue;
+			}
+
+			out << "\tmtp::def<mtp::capf::" << capf_name(def.fn) << ", " << def.base << ", " << def.step;
+
+			if (def.block_counts.size() == 1)
+				out << ", " << def.pivots.front() << ", " << def.pivots.front();
+			else
+				for (uint32_t pivot : def.pivots)
+					out << ", " << pivot;
+
+			out << ">" << (i + 1 < m_defs.size() ? "," : "") << "\n";
+		}
+
+		out << ">;\n";
+	}
+
+private:
+
+	using capf = mtp::cfg::CapacityFunction;
+
+	static constexpr uint64_t max_block_count = 1ULL << 31;
+	static constexpr uint64_t infinite_cost   = std::numeric_limits<uint64_t>::max();
+	static constexpr size_t   max_levels      = 64;
+	static constexpr size_t   max_candidates  = 64;
+
+	static constexpr std::array<capf, 7> capacity_functions {
+		capf::flat, capf::div2, capf::div4, capf::div8, capf::mul2, capf::mul4, capf::mul8
+	};
+
+	// one aligned request size: the block it needs and the most blocks of it live at once
+
+	struct Point
+	{
+		uint32_t aligned {0};
+		uint64_t peak    {0};
+
+		std::set<uint32_t> proxies;
+
+		bool exact {true};
+	};
+
+	struct Group
+	{
+		uint64_t cost {infinite_cost};
+		uint32_t step {0};
+		capf     fn   {capf::flat};
+		uint64_t base {0};
+
+		bool explicit_counts {false};
+	};
+
+	struct Shape
+	{
+		uint64_t cost {infinite_cost};
+
+		std::vector<uint32_t> pivots;
+		std::vector<uint64_t> block_counts;
+	};
+
+	struct TraceRow
+	{
+		uint64_t peak      {0};
+		uint64_t fallbacks {0};
+	};
+
+	struct FrameStride
+	{
+		uint32_t stride      {0};
+		uint32_t block_count {0};
+		uint64_t high_water  {0};
+	};
+
+
+	static std::vector<std::string> split(const std::string& line)
+	{
+		std::vector<std::string> fields;
+		std::stringstream stream {line};
+		std::string field;
+
+		while (std::getline(stream, field, ','))
+			fields.push_back(field);
+
+		return fields;
+	}
+
+	static std::optional<uint64_t> number(const std::string& field)
+	{
+		if (field.empty() || field.find_first_not_of("0123456789") != std::string::npos)
+			return std::nullopt;
+
+		return std::stoull(field);
+	}
+
+	bool load_file(const std::filesystem::path& path)
+	{
+		std::ifstream in {path};
+		if (!in.is_open()) {
+			std::cerr << "cannot open " << path.string() << std::endl;
+			return false;
+		}
+
+		std::string line;
+		if (!std::getline(in, line))
+			return false;
+
+		const auto header = split(line);
+
+		auto column = [&header](std::string_view name) -> size_t {
+			const auto found = std::find(header.begin(), header.end(), name);
+			return found == header.end() ? header.size() : static_cast<size_t>(found - header.begin());
+		};
+
+		// frame stream: frame,proxy_index,stride,block_count,in_use,high_water,fallbacks,exhaustions
+
+		if (column("frame") < header.size()) {
+			const size_t proxy_col  = column("proxy_index");
+			const size_t stride_col = column("stride");
+			const size_t blocks_col = column("block_count");
+			const size_t high_col   = column("high_water");
+
+			while (std::getline(in, line)) {
+				const auto fields = split(line);
+				if (fields.size() < header.size())
+					continue;
+
+				const auto proxy  = number(fields[proxy_col]);
+				const auto stride = number(fields[stride_col]);
+				const auto blocks = number(fields[blocks_col]);
+				const auto high   = number(fields[high_col]);
+
+				if (!proxy || !stride || !blocks || !high)
+					continue;
+
+				FrameStride& entry = m_frames[static_cast<uint32_t>(*proxy)];
+
+				entry.stride      = static_cast<uint32_t>(*stride);
+				entry.block_count = static_cast<uint32_t>(*blocks);
+				entry.high_water  = std::max(entry.high_water, *high);
+			}
+
+			return true;
+		}
+
+		// trace export: raw_size,alignment,proxy_index,count,fallbacks,raw_total_bytes,stride_total_bytes
+
+		const size_t raw_col      = column("raw_size");
+		const size_t align_col    = column("alignment");
+		const size_t proxy_col    = column("proxy_index");
+		const size_t count_col    = column("count");
+		const size_t fallback_col = column("fallbacks");
+
+		if (raw_col >= header.size() || count_col >= header.size()) {
+			std::cerr << "not a trace file: " << path.string() << std::endl;
+			return false;
+		}
+
+		while (std::getline(in, line)) {
+			const auto fields = split(line);
+			if (fields.size() < header.size())
+				continue;
+
+			// the "?" row sums allocations that did not fit the trace table and has no size, it is only counted
+
+			const auto raw       = number(fields[raw_col]);
+			const auto alignment = number(fields[align_col]);
+			const auto proxy     = number(fields[proxy_col]);
+			const auto count     = number(fields[count_col]);
+			const auto fallbacks = number(fields[fallback_col]);
+
+			if (!raw && count) {
+				m_unkeyed += *count;
+				continue;
+			}
+
+			if (!raw || !alignment || !proxy || !count || !fallbacks)
+				continue;
+
+			TraceRow& row = m_rows[{
+				static_cast<uint32_t>(*raw),
+				static_cast<uint32_t>(*alignment),
+				static_cast<uint32_t>(*proxy)
+			}];
+
+			row.peak       = std::max(row.peak, *count);
+			row.fallbacks += *fallbacks;
+		}
+
+		++m_phase_count;
+		return true;
+	}
+
+	// a block holds the request, its header and the alignment padding, the same rounding the allocator looks up
+
+	uint32_t aligned_size(uint32_t raw_size, uint32_t alignment) const
+	{
+		const uint64_t header   = m_options.page_map ? 0U : sizeof(uint16_t);
+		const uint64_t align_to = std::max<uint64_t>(8U, alignment);
+
+		return static_cast<uint32_t>(std::min<uint64_t>(
+			(raw_size + header + align_to - 1U) & ~(align_to - 1U),
+			std::numeric_limits<uint32_t>::max()
+		));
+	}
+
+	static uint32_t round_up(uint32_t value, uint32_t step)
+	{
+		return (value + step - 1U) & ~(step - 1U);
+	}
+
+	void build_points()
+	{
+		std::map<uint32_t, Point> points;
+		std::set<uint32_t> fallback_proxies;
+
+		for (const auto& [key, row] : m_rows) {
+			if (row.peak == 0)
+				continue;
+
+			const uint32_t aligned = aligned_size(key[0], key[1]);
+
+			if (aligned > mtp::cfg::MetapoolConstraints::max_stride) {
+				++m_skipped;
+				continue;
+			}
+
+			Point& point = points[aligned];
+
+			point.aligned = aligned;
+			point.peak   += row.peak;
+			point.proxies.insert(key[2]);
+
+			if (row.fallbacks != 0)
+				fallback_proxies.insert(key[2]);
+		}
+
+		// the high-water mark of a traced stride bounds the sizes requested from it, unless some of them fell back
+
+		for (auto& [aligned, point] : points) {
+			for (uint32_t proxy : point.proxies) {
+				if (!m_frames.contains(proxy) || fallback_proxies.contains(proxy))
+					point.exact = false;
+			}
+
+			m_points.push_back(point);
+		}
+
+		for (const auto& [proxy, frame] : m_frames)
+			m_traced_bytes += static_cast<uint64_t>(frame.stride) * frame.block_count;
+	}
+
+	// blocks a stride needs for the points routed to it, headroom included
+
+	uint64_t requirement(size_t first, size_t last) const
+	{
+		uint64_t peak  = 0;
+		uint64_t bound = 0;
+
+		std::set<uint32_t> proxies;
+		bool exact = true;
+
+		for (size_t i = first; i <= last; ++i) {
+			peak  += m_points[i].peak;
+			exact &= m_points[i].exact;
+			proxies.insert(m_points[i].proxies.begin(), m_points[i].proxies.end());
+		}
+
+		if (exact && !proxies.empty()) {
+			for (uint32_t proxy : proxies)
+				bound += m_frames.at(proxy).high_water;
+
+			peak = std::min(peak, bound);
+		}
+
+		const double scaled = static_cast<double>(peak) * (1.0 + m_options.headroom);
+
+		return std::max<uint64_t>(static_cast<uint64_t>(scaled + 0.999999), 1U);
+	}
+
+	// per-stride requirements of points [first, last] under one step, 0 for strides nothing maps to
+
+	std::vector<uint64_t> stride_requirements(size_t first, size_t last, uint32_t step) const
+	{
+		const uint32_t lo = round_up(m_points[first].aligned, step);
+		const uint32_t hi = round_up(m_points[last].aligned, step);
+
+		std::vector<uint64_t> required((hi - lo) / step + 1, 0);
+
+		size_t run_first = first;
+
+		for (size_t i = first; i <= last; ++i) {
+			const uint32_t stride = round_up(m_points[i].aligned, step);
+
+			if (i == last || round_up(m_points[i + 1].aligned, step) != stride) {
+				required[(stride - lo) / step] = requirement(run_first, i);
+				run_first = i + 1;
+			}
+		}
+
+		return required;
+	}
+
+	static uint64_t factor(capf fn)
+	{
+		switch (fn) {
+			case capf::div8: case capf::mul8: return 8;
+			case capf::div4: case capf::mul4: return 4;
+			case capf::div2: case capf::mul2: return 2;
+			case capf::flat: return 1;
+		}
+
+		return 1;
+	}
+
+	static bool shrinking(capf fn)
+	{
+		return fn == capf::div2 || fn == capf::div4 || fn == capf::div8;
+	}
+
+	// block counts along the pivots of a capacity function, same integer steps as the metapool
+
+	static std::vector<uint64_t> level_counts(capf fn, uint64_t base, size_t levels)
+	{
+		std::vector<uint64_t> counts {base};
+
+		for (size_t level = 1; level < levels; ++level) {
+			const uint64_t prev = counts.back();
+
+			if (shrinking(fn))
+				counts.push_back(std::max<uint64_t>(prev / factor(fn), 1U));
+			else
+				counts.push_back(prev * factor(fn));
+
+			if (counts.back() > max_block_count) {
+				counts.pop_back();
+				break;
+			}
+		}
+
+		return counts;
+	}
+
+	// every stride holds exactly its own need, one block where nothing was traced
+
+	static Shape explicit_shape(const std::vector<uint64_t>& required, uint32_t lo, uint32_t step, bool with_pivots)
+	{
+		Shape result;
+
+		uint64_t cost = 0;
+
+		for (size_t i = 0; i < required.size(); ++i) {
+			const uint64_t blocks = std::max<uint64_t>(required[i], 1U);
+
+			if (blocks > max_block_count)
+				return result;
+
+			cost += blocks * (lo + i * step);
+
+			if (with_pivots)
+				result.block_counts.push_back(blocks);
+		}
+
+		result.cost = cost;
+
+		if (with_pivots)
+			result.pivots = {lo, static_cast<uint32_t>(lo + (required.size() - 1) * step)};
+
+		return result;
+	}
+
+	// level of every stride: a pivot moves to the next level, the last stride is always a pivot.
+	// shrinking functions descend as early as every later stride allows, growing ones climb as late as possible
+
+	static Shape shape(const std::vector<uint64_t>& required, uint32_t lo, uint32_t step, capf fn, uint64_t base, bool with_pivots)
+	{
+		Shape result;
+
+		const size_t count = required.size();
+
+		if (count == 1) {
+			if (base < required[0])
+				return result;
+
+			result.cost = base * lo;
+
+			if (with_pivots) {
+				result.pivots       = {lo};
+				result.block_counts = {base};
+			}
+
+			return result;
+		}
+
+		const auto counts = level_counts(fn, base, std::min(count + 1, max_levels));
+		const size_t top  = counts.size() - 1;
+
+		std::vector<size_t> level(count, 0);
+
+		if (fn == capf::flat) {
+			for (uint64_t need : required) {
+				if (need > base)
+					return result;
+			}
+
+			level.back() = 1;
+		}
+		else if (shrinking(fn)) {
+
+			// deepest level whose count still holds the stride, never deeper than the first level at 1 block
+
+			size_t floor_level = 0;
+			while (floor_level < top && counts[floor_level] > 1)
+				++floor_level;
+
+			auto deepest = [&](uint64_t need) -> std::optional<size_t> {
+				if (counts[0] < need)
+					return std::nullopt;
+
+				size_t l = 0;
+				while (l < floor_level && counts[l + 1] >= need)
+					++l;
+				return l;
+			};
+
+			const auto last_level = deepest(required.back());
+			if (!last_level || *last_level == 0)
+				return result;
+
+			std::vector<size_t> limit(count - 1, 0);
+
+			size_t suffix = *last_level - 1;
+
+			for (size_t i = count - 1; i-- > 0;) {
+				const auto l = deepest(required[i]);
+				if (!l)
+					return result;
+
+				suffix   = std::min(suffix, *l);
+				limit[i] = suffix;
+			}
+
+			for (size_t i = 1; i + 1 < count; ++i)
+				level[i] = std::min(level[i - 1] + 1, limit[i]);
+
+			level.back() = level[count - 2] + 1;
+
+			if (level.back() > top)
+				return result;
+		}
+		else {
+			auto lowest = [&](uint64_t need) -> std::optional<size_t> {
+				for (size_t l = 0; l <= top; ++l) {
+					if (counts[l] >= need)
+						return l;
+				}
+				return std::nullopt;
+			};
+
+			const auto last_level = lowest(required.back());
+			if (!last_level)
+				return result;
+
+			// a stride can climb only one level past its predecessor, so later needs pull earlier levels up
+
+			std::vector<size_t> floor(count - 1, 0);
+
+			size_t carried = *last_level == 0 ? 0 : *last_level - 1;
+
+			for (size_t i = count - 1; i-- > 0;) {
+				const auto l = lowest(required[i]);
+				if (!l)
+					return result;
+
+				floor[i] = std::max(*l, carried);
+				carried  = floor[i] == 0 ? 0 : floor[i] - 1;
+			}
+
+			if (floor[0] != 0)
+				return result;
+
+			for (size_t i = 1; i + 1 < count; ++i)
+				level[i] = std::max(level[i - 1], floor[i]);
+
+			level.back() = level[count - 2] + 1;
+
+			if (level.back() > top)
+				return result;
+		}
+
+		uint64_t cost = 0;
+
+		for (size_t i = 0; i < count; ++i)
+			cost += counts[level[i]] * (lo + static_cast<uint64_t>(i) * step);
+
+		result.cost = cost;
+
+		if (with_pivots) {
+			result.pivots.push_back(lo);
+
+			for (size_t i = 1; i < count; ++i) {
+				if (level[i] != level[i - 1])
+					result.pivots.push_back(lo + static_cast<uint32_t>(i) * step);
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				result.block_counts.push_back(counts[level[i]]);
+		}
+
+		return result;
+	}
+
+	// a stride is tight at some level in the cheapest shape, so the base is one of those thresholds
+
+	static std::vector<uint64_t> base_candidates(const std::vector<uint64_t>& required, capf fn)
+	{
+		uint64_t most = 1;
+		for (uint64_t need : required)
+			most = std::max(most, need);
+
+		std::vector<uint64_t> candidates;
+
+		if (fn == capf::flat) {
+			candidates.push_back(most);
+			return candidates;
+		}
+
+		const uint64_t f = factor(fn);
+
+		for (uint64_t need : required) {
+			if (need == 0)
+				continue;
+
+			uint64_t scale = 1;
+
+			for (size_t level = 0; level < 8 && scale <= max_block_count; ++level, scale *= f) {
+				const uint64_t base = shrinking(fn) ? need * scale : (need + scale - 1) / scale;
+
+				if (base >= required.front() && base <= max_block_count && (!shrinking(fn) || base >= most))
+					candidates.push_back(base);
+			}
+		}
+
+		if (shrinking(fn))
+			candidates.push_back(most);
+		else
+			candidates.push_back(std::max<uint64_t>(required.front(), 1U));
+
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		if (candidates.size() > max_candidates)
+			candidates.resize(max_candidates);
+
+		return candidates;
+	}
+
+	Group best_shape(size_t first, size_t last, uint32_t step) const
+	{
+		Group best;
+
+		const auto required = stride_requirements(first, last, step);
+		const uint32_t lo   = round_up(m_points[first].aligned, step);
+
+		for (capf fn : capacity_functions) {
+			for (uint64_t base : base_candidates(required, fn)) {
+				const Shape candidate = shape(required, lo, step, fn, base, false);
+
+				if (candidate.cost < best.cost)
+					best = {candidate.cost, step, fn, base};
+			}
+		}
+
+		if (m_options.explicit_counts) {
+			const Shape candidate = explicit_shape(required, lo, step, false);
+
+			if (candidate.cost < best.cost)
+				best = {candidate.cost, step, capf::flat, std::max<uint64_t>(required.front(), 1U), true};
+		}
+
+		return best;
+	}
+
+	// cheapest def for every run of consecutive points; a range must end below the next point,
+	// otherwise the lookup would route that point into it
+
+	void build_groups()
+	{
+		const size_t n = m_points.size();
+
+		m_groups.assign(n, std::vector<Group>(n));
+
+		for (size_t first = 0; first < n; ++first) {
+			for (uint32_t step = mtp::cfg::MetapoolConstraints::min_stride_step;
+				step <= mtp::cfg::MetapoolConstraints::max_stride_step; step <<= 1)
+			{
+				const uint32_t lo = round_up(m_points[first].aligned, step);
+
+				if (lo > mtp::cfg::MetapoolConstraints::max_stride || lo < m_points[first].aligned)
+					break;
+
+				for (size_t last = first; last < n; ++last) {
+					const uint64_t hi = round_up(m_points[last].aligned, step);
+
+					if (hi > mtp::cfg::MetapoolConstraints::max_stride || (hi - lo) / step + 1 > m_options.max_strides)
+						break;
+
+					if (last + 1 < n && hi >= m_points[last + 1].aligned)
+						continue;
+
+					const Group group = best_shape(first, last, step);
+
+					if (group.cost < m_groups[first][last].cost)
+						m_groups[first][last] = group;
+				}
+
+				// wider steps only make sense once a single stride can no longer hold the first point exactly
+
+				if (step >= m_points[first].aligned)
+					break;
+			}
+		}
+	}
+
+	void partition()
+	{
+		const size_t n = m_points.size();
+		const size_t k = std::max<size_t>(m_options.max_defs, 1U);
+
+		// cost[d][j]: points [0, j) covered by d defs
+
+		std::vector<std::vector<uint64_t>> cost(k + 1, std::vector<uint64_t>(n + 1, infinite_cost));
+		std::vector<std::vector<size_t>>   from(k + 1, std::vector<size_t>(n + 1, 0));
+
+		cost[0][0] = 0;
+
+		for (size_t d = 1; d <= k; ++d) {
+			for (size_t end = 1; end <= n; ++end) {
+				for (size_t begin = 0; begin < end; ++begin) {
+					const uint64_t prev  = cost[d - 1][begin];
+					const uint64_t group = m_groups[begin][end - 1].cost;
+
+					if (prev == infinite_cost || group == infinite_cost)
+						continue;
+
+					if (prev + group < cost[d][end]) {
+						cost[d][end] = prev + group;
+						from[d][end] = begin;
+					}
+				}
+			}
+		}
+
+		size_t defs = 0;
+		for (size_t d = 1; d <= k; ++d) {
+			if (cost[d][n] != infinite_cost && (defs == 0 || cost[d][n] < cost[defs][n]))
+				defs = d;
+		}
+
+		if (defs == 0)
+			return;
+
+		std::vector<std::pair<size_t, size_t>> runs;
+
+		for (size_t end = n, d = defs; d > 0; --d) {
+			const size_t begin = from[d][end];
+			runs.emplace_back(begin, end - 1);
+			end = begin;
+		}
+
+		std::reverse(runs.begin(), runs.end());
+
+		for (const auto& [first, last] : runs) {
+			const Group& group = m_groups[first][last];
+
+			const auto required = stride_requirements(first, last, group.step);
+			const uint32_t lo   = round_up(m_points[first].aligned, group.step);
+
+			Shape built = group.explicit_counts
+				? explicit_shape(required, lo, group.step, true)
+				: shape(required, lo, group.step, group.fn, group.base, true);
+
+			Def def;
+			def.fn              = group.fn;
+			def.base            = group.base;
+			def.step            = group.step;
+			def.explicit_counts = group.explicit_counts;
+			def.pivots          = std::move(built.pivots);
+			def.block_counts    = std::move(built.block_counts);
+			def.bytes           = built.cost;
+
+			m_defs.push_back(std::move(def));
+		}
+	}
+
+	// routes every traced size through the recommended ranges the way the allocator looks it up
+
+	void verify() const
+	{
+		std::vector<std::map<uint32_t, std::vector<size_t>>> routed(m_defs.size());
+
+		for (size_t i = 0; i < m_points.size(); ++i) {
+			const uint32_t aligned = m_points[i].aligned;
+
+			for (size_t d = 0; d < m_defs.size(); ++d) {
+				const Def& def = m_defs[d];
+				const uint32_t stride = std::max(round_up(aligned, def.step), def.pivots.front());
+
+				if (stride <= def.pivots.front() + (def.block_counts.size() - 1) * def.step) {
+					routed[d][stride].push_back(i);
+					break;
+				}
+			}
+		}
+
+		for (size_t d = 0; d < m_defs.size(); ++d) {
+			for (const auto& [stride, points] : routed[d]) {
+				const uint64_t need   = requirement(points.front(), points.back());
+				const uint64_t blocks = m_defs[d].block_counts[(stride - m_defs[d].pivots.front()) / m_defs[d].step];
+
+				if (blocks < need)
+					std::cerr << "warning: stride " << stride << " holds " << blocks << " of " << need << " blocks" << std::endl;
+			}
+		}
+	}
+
+	static std::string_view capf_name(capf fn)
+	{
+		switch (fn) {
+			case capf::div8: return "div8";
+			case capf::div4: return "div4";
+			case capf::div2: return "div2";
+			case capf::flat: return "flat";
+			case capf::mul2: return "mul2";
+			case capf::mul4: return "mul4";
+			case capf::mul8: return "mul8";
+		}
+
+		return "flat";
+	}
+
+	static std::string format_bytes(uint64_t bytes)
+	{
+		std::ostringstream out;
+		out << bytes;
+
+		if (bytes >= (1ULL << 20))
+			out << " (" << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1ULL << 20) << " MiB)";
+		else if (bytes >= (1ULL << 10))
+			out << " (" << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1ULL << 10) << " KiB)";
+
+		return out.str();
+	}
+
+private:
+
+	Options m_options;
+
+	std::map<std::array<uint32_t, 3>, TraceRow> m_rows;
+	std::map<uint32_t, FrameStride>             m_frames;
+
+	std::vector<Point>              m_points;
+	std::vector<std::vector<Group>> m_groups;
+	std::vector<Def>                m_defs;
+
+	size_t   m_phase_count  {0};
+	size_t   m_skipped      {0};
+	uint64_t m_unkeyed      {0};
+	uint64_t m_traced_bytes {0};
+};
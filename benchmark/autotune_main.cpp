@@ -0,0 +1,121 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+#include "autotune.hpp"
+
+
+
+static void print_usage()
+{
+	std::cerr
+		<< "usage: mtp_autotune [options] <trace.csv | trace_folder>...\n\n"
+		<< "  --out <file>         generated header (default: tuned_set.hpp)\n"
+		<< "  --name <alias>       metaset alias (default: tuned_set)\n"
+		<< "  --headroom <pct>     extra blocks over the observed peak (default: 20)\n"
+		<< "  --max-defs <n>       most metapools in the set (default: 8)\n"
+		<< "  --max-strides <n>    most strides in one metapool (default: 256)\n"
+		<< "  --page-map           size for header-free blocks (set_options page_map)\n"
+		<< "  --explicit           allow def_explicit ranges with the traced count of every stride\n"
+		<< "  --allow-totals       size strides without a frame stream bound from cumulative counts\n"
+		<< std::endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+	Autotuner::Options options;
+
+	std::string out_path = "tuned_set.hpp";
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+
+		auto value = [&]() -> std::string {
+			if (i + 1 >= argc) {
+				std::cerr << "missing value for " << arg << std::endl;
+				std::exit(1);
+			}
+			return argv[++i];
+		};
+
+		try {
+			if (arg == "--out")
+				out_path = value();
+			else if (arg == "--name")
+				options.name = value();
+			else if (arg == "--headroom")
+				options.headroom = std::stod(value()) / 100.0;
+			else if (arg == "--max-defs")
+				options.max_defs = std::stoul(value());
+			else if (arg == "--max-strides")
+				options.max_strides = static_cast<uint32_t>(std::stoul(value()));
+			else if (arg == "--page-map")
+				options.page_map = true;
+			else if (arg == "--explicit")
+				options.explicit_counts = true;
+			else if (arg == "--allow-totals")
+				options.allow_totals = true;
+			else if (arg == "--help" || arg == "-h") {
+				print_usage();
+				return 0;
+			}
+			else if (arg.starts_with("--")) {
+				std::cerr << "unknown option: " << arg << std::endl;
+				print_usage();
+				return 1;
+			}
+			else
+				inputs.push_back(arg);
+		}
+		catch (const std::exception&) {
+			std::cerr << "invalid value for " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	if (inputs.empty()) {
+		print_usage();
+		return 1;
+	}
+
+	Autotuner tuner {options};
+
+	std::string sources;
+
+	for (const auto& input : inputs) {
+		if (!tuner.load(input)) {
+			std::cerr << "no trace data in " << input << std::endl;
+			return 1;
+		}
+
+		sources += (sources.empty() ? "" : ", ") + input;
+	}
+
+	if (!tuner.tune()) {
+		std::cerr << "no metaset fits the traced sizes, try a larger --max-defs or --max-strides" << std::endl;
+		return 1;
+	}
+
+	if (const size_t unbounded = tuner.unbounded_sizes(); unbounded != 0 && !options.allow_totals) {
+		std::cerr << unbounded << " traced sizes have no frame high-water bound, their cumulative counts are not live peaks\n"
+			<< "record a frame stream with mtp::trace_frames_open next to the trace, or pass --allow-totals" << std::endl;
+		return 1;
+	}
+
+	tuner.print_report(std::cout);
+
+	std::ofstream out {out_path};
+	if (!out.is_open()) {
+		std::cerr << "cannot write " << out_path << std::endl;
+		return 1;
+	}
+
+	tuner.write_header(out, sources);
+
+	std::cout << "metaset written: " << out_path << std::endl;
+
+	return 0;
+}
@@ -2,29 +2,34 @@
 #include <string>
 #include <memory>
 #include <iostream>
+#include <functional>
 
 #include "benchmark.hpp"
 #include "benchmark_micro.hpp"
+#include "benchmark_replay.hpp"
 #include "benchmark_selective.hpp"
 
 
 
 std::unique_ptr<Benchmark> create_benchmark_selective();
 std::unique_ptr<Benchmark> create_benchmark_micro();
+std::unique_ptr<Benchmark> create_benchmark_replay(std::string path);
 
 
 
 int main(int argc, char* argv[])
 {
 	if (argc < 2) {
-		std::cerr << "usage: metapool [selective|micro]" << std::endl;
+		std::cerr << "usage: metapool [selective|micro|replay <log>]" << std::endl;
 		return 1;
 	}
 
-	const std::map<std::string, std::unique_ptr<Benchmark>(*)()> benchmark_factories = {
-		{"selective", create_benchmark_selective},
-		{"micro",     create_benchmark_micro}
+	const std::string replay_log = (argc > 2) ? argv[2] : "trace/replay.mtprec";
 
+	const std::map<std::string, std::function<std::unique_ptr<Benchmark>()>> benchmark_factories = {
+		{"selective", create_benchmark_selective},
+		{"micro",     create_benchmark_micro},
+		{"replay",    [&replay_log] { return create_benchmark_replay(replay_log); }}
 	};
 
 	std::string type = argv[1];
@@ -32,7 +37,7 @@ int main(int argc, char* argv[])
 	auto factory_it = benchmark_factories.find(type);
 	if (factory_it == benchmark_factories.end()) {
 		std::cerr << "unknown benchmark type: " << type << std::endl;
-		std::cerr << "available types: selective, micro" << std::endl;
+		std::cerr << "available types: selective, micro, replay" << std::endl;
 		return 1;
 	}
 
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <thread>
 #include <vector>
 #include <iostream>
 #include <string_view>
@@ -80,6 +82,11 @@ private:
 		mtp::def<mtp::capf::flat, 2, 8, 640'000'000, 640'000'000>
 	>;
 
+	using SharedSet = mtp::metaset <
+
+		mtp::def<mtp::capf::flat, 16384, 16, 16, 256>
+	>;
+
 public:
 
 	inline void setup() override
@@ -111,6 +118,8 @@ public:
 		std::cout << std::endl;
 
 		print_summary(m_reserve_entries, m_emplace_entries);
+
+		run_threaded();
 	}
 
 private:
@@ -372,6 +381,131 @@ private:
 	}
 
 
+	// multithreaded churn: every thread allocates a batch of mixed small sizes and frees it again, through
+	// one lock-free shared instance directly and through a per-thread magazine cache in front of the same instance
+
+	static constexpr size_t churn_rounds = 10'000;
+	static constexpr size_t churn_batch  = 256;
+
+	static constexpr uint32_t churn_size(size_t index)
+	{
+		return static_cast<uint32_t>(8 + (index * 7 % 16) * 14);
+	}
+
+	template <typename Alloc, typename Free>
+	static void churn(Alloc&& alloc, Free&& free)
+	{
+		std::array<std::byte*, churn_batch> blocks {};
+
+		for (size_t round = 0; round < churn_rounds; ++round) {
+			for (size_t i = 0; i < churn_batch; ++i) {
+				blocks[i] = alloc(churn_size(i));
+				*blocks[i] = std::byte {1};
+			}
+
+			for (size_t i = 0; i < churn_batch; ++i)
+				free(blocks[i], churn_size(i));
+		}
+	}
+
+	// all threads start together, the time covers the slowest one
+
+	template <typename Body>
+	static double run_threads(size_t thread_count, Body body)
+	{
+		std::vector<std::thread> threads;
+		std::atomic<size_t> ready {0};
+		std::atomic<bool>   start {false};
+
+		for (size_t i = 0; i < thread_count; ++i) {
+			threads.emplace_back([&] {
+				ready.fetch_add(1, std::memory_order_relaxed);
+
+				while (!start.load(std::memory_order_acquire))
+					std::this_thread::yield();
+
+				body();
+			});
+		}
+
+		while (ready.load(std::memory_order_relaxed) != thread_count)
+			std::this_thread::yield();
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+		start.store(true, std::memory_order_release);
+
+		for (auto& thread : threads)
+			thread.join();
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::milli>(t2 - t1).count();
+	}
+
+	void run_threaded()
+	{
+		const size_t max_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 4, 16);
+
+		std::cout << "\nrunning threaded churn tests (" << churn_rounds << " x " << churn_batch
+			<< " allocs + frees per thread)...\n" << std::endl;
+
+		std::cout << std::left
+			<< std::setw(12) << "threads"
+			<< std::setw(14) << "std (ms)"
+			<< std::setw(14) << "pmr (ms)"
+			<< std::setw(18) << "lock-free (ms)"
+			<< "magazine (ms)\n";
+
+		std::cout << std::string(12 + 14 + 14 + 18 + 13, '-') << "\n";
+
+		for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+			const double t_std = run_threads(thread_count, [] {
+				churn(
+					[](uint32_t size) { return static_cast<std::byte*>(::operator new(size)); },
+					[](std::byte* block, uint32_t) { ::operator delete(block); }
+				);
+			});
+
+			std::pmr::synchronized_pool_resource pool;
+
+			const double t_pmr = run_threads(thread_count, [&pool] {
+				churn(
+					[&pool](uint32_t size) { return static_cast<std::byte*>(pool.allocate(size, 8)); },
+					[&pool](std::byte* block, uint32_t size) { pool.deallocate(block, size, 8); }
+				);
+			});
+
+			mtp::shared_lock_free<SharedSet> shared;
+
+			const double t_lock_free = run_threads(thread_count, [&shared] {
+				auto& allocator = shared.get();
+
+				churn(
+					[&allocator](uint32_t size) { return allocator.alloc(size, 8); },
+					[&allocator](std::byte* block, uint32_t) { allocator.free(block); }
+				);
+			});
+
+			const double t_magazine = run_threads(thread_count, [&shared] {
+				mtp::magazine_cache<SharedSet> cache {shared};
+
+				churn(
+					[&cache](uint32_t size) { return cache.alloc(size, 8); },
+					[&cache](std::byte* block, uint32_t) { cache.free(block); }
+				);
+			});
+
+			std::cout << std::left << std::fixed
+				<< std::setw(12) << thread_count
+				<< std::setw(14) << t_std
+				<< std::setw(14) << t_pmr
+				<< std::setw(18) << t_lock_free
+				<< t_magazine << "\n";
+		}
+
+		std::cout << "\n\n";
+	}
+
+
 	void print_summary(std::span<const BenchmarkEntry> reserve, std::span<const BenchmarkEntry> emplace)
 	{
 		auto ratio_str = [](double base, double val) -> std::string {
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+
+#include "mtp_memory.hpp"
+
+#include "benchmark.hpp"
+
+
+
+// replays an allocation log written with mtp::record_open / record_close against malloc, pmr and metapool
+// events run on one thread in log order, the recorded thread ids are kept in the log but not scheduled
+
+class BenchmarkReplay : public Benchmark
+{
+private:
+
+	using Set = mtp::default_set;
+
+	using Event = mtp::cfg::RecordEvent;
+	using Kind  = mtp::cfg::RecordKind;
+
+	static constexpr size_t repetitions  = 3;
+	static constexpr size_t source_count = 256;
+
+public:
+
+	explicit BenchmarkReplay(std::string path)
+		: m_path {std::move(path)}
+	{}
+
+	inline void setup() override
+	{
+		std::cout << "\n\n\n--- METAPOOL REPLAY BENCHMARK ---\n" << std::endl;
+
+		m_events = mtp::cfg::load_record(m_path);
+
+		if (m_events.empty()) {
+			std::cout << "no events in " << m_path << " (record one with MTP_ENABLE_RECORD and mtp::record_open)\n" << std::endl;
+			return;
+		}
+
+		prepare();
+
+		std::cout << "log: " << m_path << "\n"
+			<< "events: " << m_events.size()
+			<< " (alloc " << m_alloc_count << ", free " << m_free_count << ", reset " << m_reset_lists.size() << ")\n"
+			<< "peak live: " << m_peak_live << "\n" << std::endl;
+
+		if (m_dropped_frees != 0)
+			std::cout << "dropped " << m_dropped_frees << " frees of handles no alloc in the log produced\n" << std::endl;
+	}
+
+	inline void teardown() override
+	{
+		mtp::get_tls_allocator<Set>().reset();
+	}
+
+	inline void run() override
+	{
+		if (m_events.empty())
+			return;
+
+		m_results[0] = best_of([this] { return replay_malloc(); });
+		m_results[1] = best_of([this] { return replay_pmr(); });
+		m_results[2] = best_of([this] { return replay_mtp(); });
+
+		print_summary();
+	}
+
+private:
+
+	// every reset is resolved up front to the handles its source still had live, so the timed loops only index
+
+	inline void prepare()
+	{
+		uint64_t handle_bound = 0;
+
+		for (const Event& event : m_events) {
+			if (event.kind == Kind::alloc)
+				handle_bound = std::max(handle_bound, event.handle + 1);
+		}
+
+		// a free of a handle no alloc produced comes from a corrupt or foreign log, the timed loops index blocks
+		// by handle without a bound check, so such events are dropped here
+
+		m_dropped_frees = std::erase_if(m_events, [handle_bound](const Event& event) {
+			return event.kind == Kind::free && event.handle >= handle_bound;
+		});
+
+		m_sizes.assign(handle_bound, 0);
+		m_alignments.assign(handle_bound, 0);
+		m_sources.assign(handle_bound, 0);
+
+		std::vector<uint8_t> live(handle_bound, 0);
+		std::array<std::vector<uint64_t>, source_count> source_live;
+
+		size_t live_count = 0;
+
+		m_reset_index.assign(m_events.size(), 0);
+
+		for (size_t i = 0; i < m_events.size(); ++i) {
+			const Event& event = m_events[i];
+
+			switch (event.kind) {
+				case Kind::alloc:
+					m_sizes[event.handle]      = event.size;
+					m_alignments[event.handle] = std::max<uint32_t>(event.alignment, 1U);
+					m_sources[event.handle]    = event.source;
+					m_used_sources[event.source] = true;
+
+					live[event.handle] = 1;
+					source_live[event.source].push_back(event.handle);
+
+					++m_alloc_count;
+					m_peak_live = std::max(m_peak_live, ++live_count);
+					break;
+
+				case Kind::free:
+					if (live[event.handle] != 0) {
+						live[event.handle] = 0;
+						--live_count;
+					}
+					++m_free_count;
+					break;
+
+				case Kind::reset: {
+					std::vector<uint64_t> handles;
+
+					for (uint64_t handle : source_live[event.source]) {
+						if (live[handle] != 0) {
+							live[handle] = 0;
+							handles.push_back(handle);
+						}
+					}
+
+					source_live[event.source].clear();
+
+					m_reset_whole.push_back(handles.size() == live_count);
+					live_count -= handles.size();
+
+					m_reset_index[i] = m_reset_lists.size();
+					m_reset_lists.push_back(std::move(handles));
+					break;
+				}
+			}
+		}
+	}
+
+	template <typename Replay>
+	inline double best_of(Replay&& replay)
+	{
+		double best = 0.0;
+
+		for (size_t rep = 0; rep < repetitions; ++rep) {
+			const double elapsed = replay();
+			best = (rep == 0) ? elapsed : std::min(best, elapsed);
+		}
+
+		return best;
+	}
+
+	inline void touch(void* block, uint64_t handle) const
+	{
+		if (m_sizes[handle] >= k_qword)
+			*static_cast<uint64_t*>(block) = handle;
+		else
+			*static_cast<uint8_t*>(block) = static_cast<uint8_t>(handle);
+	}
+
+	inline double replay_malloc()
+	{
+		std::cout << "replay malloc..." << std::endl;
+
+		std::vector<void*> blocks(m_sizes.size(), nullptr);
+
+		auto release = [&](uint64_t handle) {
+			std::free(blocks[handle]);
+			blocks[handle] = nullptr;
+		};
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		for (size_t i = 0; i < m_events.size(); ++i) {
+			const Event& event = m_events[i];
+
+			switch (event.kind) {
+				case Kind::alloc: {
+					const size_t alignment = m_alignments[event.handle];
+
+					void* block = (alignment <= alignof(std::max_align_t))
+						? std::malloc(event.size)
+						: std::aligned_alloc(alignment, (event.size + alignment - 1) & ~(alignment - 1));
+
+					touch(block, event.handle);
+					blocks[event.handle] = block;
+					break;
+				}
+
+				case Kind::free:
+					release(event.handle);
+					break;
+
+				case Kind::reset:
+					for (uint64_t handle : m_reset_lists[m_reset_index[i]])
+						release(handle);
+					break;
+			}
+		}
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		for (void* block : blocks)
+			std::free(block);
+
+		const double elapsed = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		std::cout << "replay malloc: " << elapsed << " ms\n";
+		return elapsed;
+	}
+
+	// one pool per recorded allocator instance, a reset releases the whole pool
+
+	inline double replay_pmr()
+	{
+		std::cout << "replay pmr..." << std::endl;
+
+		std::vector<void*> blocks(m_sizes.size(), nullptr);
+
+		std::array<std::unique_ptr<std::pmr::unsynchronized_pool_resource>, source_count> pools;
+
+		for (size_t source = 0; source < source_count; ++source) {
+			if (m_used_sources[source])
+				pools[source] = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+		}
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		for (size_t i = 0; i < m_events.size(); ++i) {
+			const Event& event = m_events[i];
+
+			switch (event.kind) {
+				case Kind::alloc: {
+					void* block = pools[event.source]->allocate(event.size, m_alignments[event.handle]);
+
+					touch(block, event.handle);
+					blocks[event.handle] = block;
+					break;
+				}
+
+				case Kind::free: {
+					const uint64_t handle = event.handle;
+
+					if (blocks[handle] != nullptr) {
+						pools[m_sources[handle]]->deallocate(blocks[handle], m_sizes[handle], m_alignments[handle]);
+						blocks[handle] = nullptr;
+					}
+					break;
+				}
+
+				case Kind::reset:
+					if (pools[event.source] != nullptr)
+						pools[event.source]->release();
+
+					for (uint64_t handle : m_reset_lists[m_reset_index[i]])
+						blocks[handle] = nullptr;
+					break;
+			}
+		}
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		const double elapsed = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		std::cout << "replay pmr: " << elapsed << " ms\n";
+		return elapsed;
+	}
+
+	// all sources share the thread-local allocator: a reset rewinds it when nothing else is live,
+	// otherwise the blocks of the source are freed one by one; sizes the set cannot serve go to malloc
+
+	inline double replay_mtp()
+	{
+		std::cout << "replay mtp..." << std::endl;
+
+		auto& allocator = mtp::get_tls_allocator<Set>();
+
+		allocator.reset();
+
+		std::vector<void*>   blocks(m_sizes.size(), nullptr);
+		std::vector<uint8_t> foreign(m_sizes.size(), 0);
+
+		size_t fallbacks = 0;
+
+		auto release = [&](uint64_t handle) {
+			if (foreign[handle] != 0)
+				std::free(blocks[handle]);
+			else
+				allocator.free(static_cast<std::byte*>(blocks[handle]));
+
+			blocks[handle] = nullptr;
+		};
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		for (size_t i = 0; i < m_events.size(); ++i) {
+			const Event& event = m_events[i];
+
+			switch (event.kind) {
+				case Kind::alloc: {
+					void* block = allocator.try_alloc(event.size, m_alignments[event.handle]);
+
+					if (block == nullptr) [[unlikely]] {
+						block = std::aligned_alloc(m_alignments[event.handle],
+							(event.size + m_alignments[event.handle] - 1) & ~size_t(m_alignments[event.handle] - 1));
+
+						foreign[event.handle] = 1;
+						++fallbacks;
+					}
+
+					touch(block, event.handle);
+					blocks[event.handle] = block;
+					break;
+				}
+
+				case Kind::free:
+					if (blocks[event.handle] != nullptr)
+						release(event.handle);
+					break;
+
+				case Kind::reset: {
+					const auto& handles = m_reset_lists[m_reset_index[i]];
+
+					if (m_reset_whole[m_reset_index[i]]) {
+						for (uint64_t handle : handles) {
+							if (foreign[handle] != 0)
+								std::free(blocks[handle]);
+
+							blocks[handle] = nullptr;
+						}
+
+						allocator.reset();
+					}
+					else {
+						for (uint64_t handle : handles)
+							release(handle);
+					}
+					break;
+				}
+			}
+		}
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		for (size_t handle = 0; handle < blocks.size(); ++handle) {
+			if (foreign[handle] != 0)
+				std::free(blocks[handle]);
+		}
+
+		allocator.reset();
+
+		const double elapsed = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		std::cout << "replay mtp: " << elapsed << " ms";
+
+		if (fallbacks != 0)
+			std::cout << " (" << fallbacks << " allocations outside the set served by malloc)";
+
+		std::cout << "\n";
+		return elapsed;
+	}
+
+
+	void print_summary()
+	{
+		constexpr std::array<std::string_view, 3> labels {"malloc", "pmr", "mtp"};
+
+		auto ratio_str = [](double base, double val) -> std::string {
+			if (base == 0.0 || val == 0.0) return "-";
+			double r = val >= base ? val / base : base / val;
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(2) << r << "x "
+			    << (val > base ? "slower" : "faster");
+			return oss.str();
+		};
+
+		constexpr int gap = 4;
+
+		std::cout << "\n" << std::left
+			<< std::setw(8 + gap)  << "--- replay"
+			<< std::setw(12 + gap) << "time (ms)"
+			<< std::setw(10 + gap) << "ns/event"
+			<< "mtp vs" << "\n";
+
+		std::cout << std::string(8 + 12 + 10 + 14 + gap * 3, '-') << "\n";
+
+		for (size_t i = 0; i < labels.size(); ++i) {
+			std::ostringstream time_os, per_event_os;
+
+			time_os << std::fixed << std::setprecision(3) << m_results[i];
+			per_event_os << std::fixed << std::setprecision(2) << m_results[i] * 1e6 / static_cast<double>(m_events.size());
+
+			std::cout << std::left
+				<< std::setw(8 + gap)  << labels[i]
+				<< std::setw(12 + gap) << time_os.str()
+				<< std::setw(10 + gap) << per_event_os.str()
+				<< (i == 2 ? "-" : ratio_str(m_results[i], m_results[2])) << "\n";
+		}
+
+		std::cout << "\n\n";
+	}
+
+private:
+
+	std::string m_path;
+
+	std::vector<Event> m_events;
+
+	std::vector<uint32_t> m_sizes;
+	std::vector<uint32_t> m_alignments;
+	std::vector<uint8_t>  m_sources;
+
+	std::array<bool, source_count> m_used_sources {};
+
+	std::vector<size_t>                m_reset_index;
+	std::vector<std::vector<uint64_t>> m_reset_lists;
+	std::vector<bool>                  m_reset_whole;
+
+	size_t m_alloc_count   {0};
+	size_t m_free_count    {0};
+	size_t m_dropped_frees {0};
+	size_t m_peak_live     {0};
+
+	std::array<double, 3> m_results {};
+};
+
+inline std::unique_ptr<Benchmark> create_benchmark_replay(std::string path)
+{
+	return std::make_unique<BenchmarkReplay>(std::move(path));
+}
@@ -14,6 +14,7 @@
 #endif
 
 #include "../mtp/mtpint.hpp"
+#include "../mtp/frame_arena.hpp"
 #include "../mtp/memory_model.hpp"
 
 
@@ -53,19 +54,32 @@ inline auto make_vector(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_vector(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::vector<T, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::vector<T, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_vector(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::vector<T, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_deque(Types&&... args)
 {
@@ -75,19 +89,32 @@ inline auto make_deque(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_deque(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::deque<T, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::deque<T, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_deque(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::deque<T, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_list(Types&&... args)
 {
@@ -97,19 +124,32 @@ inline auto make_list(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_list(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::list<T, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::list<T, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_list(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::list<T, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_forward_list(Types&&... args)
 {
@@ -119,19 +159,32 @@ inline auto make_forward_list(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_forward_list(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::forward_list<T, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::forward_list<T, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_forward_list(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::forward_list<T, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_set(Types&&... args)
 {
@@ -141,19 +194,32 @@ inline auto make_set(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_set(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::set<T, std::less<T>, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::set<T, std::less<T>, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_set(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::set<T, std::less<T>, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_unordered_set(Types&&... args)
 {
@@ -163,19 +229,32 @@ inline auto make_unordered_set(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_unordered_set(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::unordered_set<T, std::hash<T>, std::equal_to<T>, mtp::cfg::rebound_std_adapter<T, Set>> {
+	return std::unordered_set<T, std::hash<T>, std::equal_to<T>, mtp::cfg::rebound_shared_adapter<T, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<T, Set>(shared)
 	};
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unordered_set(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::unordered_set<T, std::hash<T>, std::equal_to<T>, mtp::core::FrameAdapter<T, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<T>()
+	};
+}
+
+
 template <typename K, typename V, typename Set, typename... Types>
 inline auto make_map(Types&&... args)
 {
@@ -186,20 +265,34 @@ inline auto make_map(Types&&... args)
 	};
 }
 
-template <typename K, typename V, typename Set, typename... Types>
+template <typename K, typename V, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_map(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
 	using Pair = std::pair<const K, V>;
-	return std::map<K, V, std::less<K>, mtp::cfg::rebound_std_adapter<Pair, Set>> {
+	return std::map<K, V, std::less<K>, mtp::cfg::rebound_shared_adapter<Pair, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<Pair, Set>(shared)
 	};
 }
 
 
+template <typename K, typename V, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_map(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	using Pair = std::pair<const K, V>;
+	return std::map<K, V, std::less<K>, mtp::core::FrameAdapter<Pair, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<Pair>()
+	};
+}
+
+
 template <typename K, typename V, typename Set, typename... Types>
 inline auto make_unordered_map(Types&&... args)
 {
@@ -210,20 +303,34 @@ inline auto make_unordered_map(Types&&... args)
 	};
 }
 
-template <typename K, typename V, typename Set, typename... Types>
+template <typename K, typename V, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_unordered_map(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
 	using Pair = std::pair<const K, V>;
-	return std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, mtp::cfg::rebound_std_adapter<Pair, Set>> {
+	return std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, mtp::cfg::rebound_shared_adapter<Pair, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<Pair, Set>(shared)
 	};
 }
 
 
+template <typename K, typename V, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unordered_map(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	using Pair = std::pair<const K, V>;
+	return std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, mtp::core::FrameAdapter<Pair, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<Pair>()
+	};
+}
+
+
 template <typename Set, typename... Types>
 inline auto make_string(Types&&... args)
 {
@@ -233,19 +340,32 @@ inline auto make_string(Types&&... args)
 	};
 }
 
-template <typename Set, typename... Types>
+template <typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_string(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
-	return std::basic_string<char, std::char_traits<char>, mtp::cfg::rebound_std_adapter<char, Set>> {
+	return std::basic_string<char, std::char_traits<char>, mtp::cfg::rebound_shared_adapter<char, Set, Policy>> {
 		std::forward<Types>(args)...,
 		mtp::core::MemoryModel::get_std_adapter<char, Set>(shared)
 	};
 }
 
 
+template <mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_string(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::basic_string<char, std::char_traits<char>, mtp::core::FrameAdapter<char, mtp::core::FrameArena<Options, Policy>>> {
+		std::forward<Types>(args)...,
+		frame.template get_std_adapter<char>()
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_unique(Types&&... args)
 {
@@ -266,9 +386,9 @@ inline auto make_unique(Types&&... args)
 	};
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_unique(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
@@ -293,6 +413,31 @@ inline auto make_unique(
 }
 
 
+// the deleter only runs the destructor, the block goes back with the frame
+
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unique(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	T* object_ptr = frame.template construct<T>(std::forward<Types>(args)...);
+
+	struct deleter final
+	{
+		void operator()(T* ptr) const noexcept
+		{
+			ptr->~T();
+		}
+	};
+
+	return std::unique_ptr<T, deleter> {
+		object_ptr,
+		deleter {}
+	};
+}
+
+
 template <typename T, typename Set, typename... Types>
 inline auto make_shared(Types&&... args)
 {
@@ -302,9 +447,9 @@ inline auto make_shared(Types&&... args)
 	);
 }
 
-template <typename T, typename Set, typename... Types>
+template <typename T, typename Set, mtp::cfg::SharedPolicy Policy, typename... Types>
 inline auto make_shared(
-	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter>& shared,
+	mtp::core::MemoryModel::Shared<Set, mtp::cfg::AllocatorTag::std_adapter, Policy>& shared,
 	Types&&... args
 )
 {
@@ -315,6 +460,19 @@ inline auto make_shared(
 }
 
 
+template <typename T, mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy, typename... Types>
+inline auto make_shared(
+	mtp::core::FrameArena<Options, Policy>& frame,
+	Types&&... args
+)
+{
+	return std::allocate_shared<T>(
+		frame.template get_std_adapter<T>(),
+		std::forward<Types>(args)...
+	);
+}
+
+
 #endif
 
 } // mtp::cntr
@@ -46,7 +46,7 @@ public:
 			>()
 		}
 	{
-		std::byte* block = m_allocator->alloc(sizeof(T) * capacity, alignof(T));
+		std::byte* block = alloc_block(capacity);
 		m_beg = reinterpret_cast<T*>(block);
 		m_end = m_beg;
 		m_cap = m_beg + capacity;
@@ -61,7 +61,7 @@ public:
 			>()
 		}
 	{
-		std::byte* block = m_allocator->alloc(sizeof(T) * count, alignof(T));
+		std::byte* block = alloc_block(count);
 		m_beg = reinterpret_cast<T*>(block);
 		m_end = m_beg + count;
 		m_cap = m_beg + count;
@@ -77,7 +77,7 @@ public:
 	vault(SharedAllocator& shared, size_t capacity)
 		: m_allocator {shared.get_ptr()}
 	{
-		std::byte* block = m_allocator->alloc(sizeof(T) * capacity, alignof(T));
+		std::byte* block = alloc_block(capacity);
 		m_beg = reinterpret_cast<T*>(block);
 		m_end = m_beg;
 		m_cap = m_beg + capacity;
@@ -87,7 +87,7 @@ public:
 	vault(SharedAllocator& shared, size_t count, Types&&... args)
 		: m_allocator {shared.get_ptr()}
 	{
-		std::byte* block = m_allocator->alloc(sizeof(T) * count, alignof(T));
+		std::byte* block = alloc_block(count);
 		m_beg = reinterpret_cast<T*>(block);
 		m_end = m_beg + count;
 		m_cap = m_beg + count;
@@ -189,6 +189,24 @@ public:
 		new (m_end++) T(std::move(value));
 	}
 
+	[[nodiscard]] bool try_push_back(const T& value)
+	{
+		if (m_end == m_cap && !try_grow()) [[unlikely]]
+			return false;
+
+		new (m_end++) T(value);
+		return true;
+	}
+
+	[[nodiscard]] bool try_push_back(T&& value)
+	{
+		if (m_end == m_cap && !try_grow()) [[unlikely]]
+			return false;
+
+		new (m_end++) T(std::move(value));
+		return true;
+	}
+
 	template <typename... Types>
 	T* emplace(const T* pos, Types&&... args)
 	{
@@ -312,29 +330,23 @@ public:
 		if (new_cap <= static_cast<size_t>(m_cap - m_beg))
 			return;
 
-		size_t count = static_cast<size_t>(m_end - m_beg);
+		reserve_into(reinterpret_cast<T*>(
+			alloc_block(new_cap)
+		), new_cap);
+	}
 
-		T* MTP_RESTRICT new_beg = reinterpret_cast<T*>(
-			m_allocator->alloc(sizeof(T) * new_cap, alignof(T))
-		);
-		T* MTP_RESTRICT new_end = new_beg;
+	[[nodiscard]] bool try_reserve(size_t new_cap)
+	{
+		if (new_cap <= static_cast<size_t>(m_cap - m_beg))
+			return true;
 
-		if constexpr (std::is_trivially_move_constructible_v<T>) {
-			std::memcpy(new_beg, m_beg, sizeof(T) * count);
-			new_end = new_beg + count;
-		}
-		else {
-			for (size_t i = 0; i < count; ++i)
-				new (new_beg + i) T(std::move(m_beg[i]));
-			new_end = new_beg + count;
-		}
+		std::byte* block = try_alloc_block(new_cap);
 
-		if (m_beg)
-			m_allocator->free(reinterpret_cast<std::byte*>(m_beg));
+		if (block == nullptr) [[unlikely]]
+			return false;
 
-		m_beg = new_beg;
-		m_end = new_end;
-		m_cap = new_beg + new_cap;
+		reserve_into(reinterpret_cast<T*>(block), new_cap);
+		return true;
 	}
 
 	void resize(size_t new_size)
@@ -403,7 +415,7 @@ public:
 			m_allocator->free(reinterpret_cast<std::byte*>(m_beg));
 
 		m_beg = reinterpret_cast<T*>(
-			m_allocator->alloc(sizeof(T) * new_capacity, alignof(T))
+			alloc_block(new_capacity)
 		);
 		m_end = m_beg;
 		m_cap = m_beg + new_capacity;
@@ -421,7 +433,7 @@ public:
 			m_allocator->free(reinterpret_cast<std::byte*>(m_beg));
 
 		m_beg = reinterpret_cast<T*>(
-			m_allocator->alloc(sizeof(T) * new_capacity, alignof(T))
+			alloc_block(new_capacity)
 		);
 		m_end = m_beg + new_capacity;
 		m_cap = m_end;
@@ -467,14 +479,61 @@ public:
 
 private:
 
+	// no block is larger than the largest stride, so an element count whose bytes and block header exceed it is
+	// rejected before the call instead of being narrowed to a small block
+
+	static constexpr size_t max_count =
+		(mtp::cfg::MetapoolConstraints::max_stride - std::remove_cvref_t<typename RawAllocator::config_type>::block_header_bytes) / sizeof(T);
+
+	[[nodiscard]] std::byte* alloc_block(size_t count)
+	{
+		if (count > max_count) [[unlikely]]
+			mtp::err::fatal(mtp::err::vault_size_overflow,
+				mtp::err::format_ctx("count = %zu, max = %zu", count, max_count));
+
+		return m_allocator->alloc(static_cast<uint32_t>(sizeof(T) * count), alignof(T));
+	}
+
+	[[nodiscard]] std::byte* try_alloc_block(size_t count) noexcept
+	{
+		if (count > max_count) [[unlikely]]
+			return nullptr;
+
+		return m_allocator->try_alloc(static_cast<uint32_t>(sizeof(T) * count), alignof(T));
+	}
+
 	void grow()
+	{
+		const size_t new_cap = grow_capacity();
+
+		grow_into(reinterpret_cast<T*>(
+			alloc_block(new_cap)
+		), new_cap);
+	}
+
+	[[nodiscard]] bool try_grow()
+	{
+		const size_t new_cap = grow_capacity();
+
+		std::byte* block = try_alloc_block(new_cap);
+
+		if (block == nullptr) [[unlikely]]
+			return false;
+
+		grow_into(reinterpret_cast<T*>(block), new_cap);
+		return true;
+	}
+
+	size_t grow_capacity() const noexcept
+	{
+		const size_t count = static_cast<size_t>(m_end - m_beg);
+		return count == 0 ? 8 : count * 2;
+	}
+
+	void grow_into(T* MTP_RESTRICT new_beg, size_t new_cap)
 	{
 		const size_t count = static_cast<size_t>(m_end - m_beg);
-		const size_t new_cap = count == 0 ? 8 : count * 2;
 
-		T* MTP_RESTRICT new_beg = reinterpret_cast<T*>(
-			m_allocator->alloc(sizeof(T) * new_cap, alignof(T))
-		);
 		T* MTP_RESTRICT old = m_beg;
 
 		if constexpr (std::is_trivially_copyable_v<T>) {
@@ -497,6 +556,30 @@ private:
 		m_cap = new_beg + new_cap;
 	}
 
+	void reserve_into(T* MTP_RESTRICT new_beg, size_t new_cap)
+	{
+		size_t count = static_cast<size_t>(m_end - m_beg);
+
+		T* MTP_RESTRICT new_end = new_beg;
+
+		if constexpr (std::is_trivially_move_constructible_v<T>) {
+			std::memcpy(new_beg, m_beg, sizeof(T) * count);
+			new_end = new_beg + count;
+		}
+		else {
+			for (size_t i = 0; i < count; ++i)
+				new (new_beg + i) T(std::move(m_beg[i]));
+			new_end = new_beg + count;
+		}
+
+		if (m_beg)
+			m_allocator->free(reinterpret_cast<std::byte*>(m_beg));
+
+		m_beg = new_beg;
+		m_end = new_end;
+		m_cap = new_beg + new_cap;
+	}
+
 	void resize_helper(size_t new_size, size_t old_size)
 	{
 		T* MTP_RESTRICT beg = m_beg;
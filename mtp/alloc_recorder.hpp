@@ -0,0 +1,297 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+
+#ifndef MTP_ENABLE_RECORD
+	#define MTP_ENABLE_RECORD 0
+#endif
+
+
+namespace mtp::cfg {
+
+
+// binary allocation log: a header followed by fixed-size events in the order they happened
+// frees are logged before the block is released and allocations after it was taken, so a block reused
+// by another thread always appears freed before it is allocated again
+
+enum class RecordKind : uint8_t
+{
+	alloc = 1,
+	free  = 2,
+	reset = 3
+};
+
+struct RecordHeader
+{
+	char     magic[8]   {'M', 'T', 'P', 'R', 'E', 'C', '0', '1'};
+	uint32_t version    {1};
+	uint32_t event_size {0};
+};
+
+// handle ids are assigned per allocation in log order, source is the allocator instance (255 = any later one)
+
+struct RecordEvent
+{
+	RecordKind kind      {RecordKind::alloc};
+	uint8_t    source    {0};
+	uint16_t   proxy     {0};
+	uint32_t   thread    {0};
+	uint32_t   size      {0};
+	uint32_t   alignment {0};
+	uint64_t   handle    {0};
+};
+
+static_assert(sizeof(RecordEvent) == 24);
+
+
+[[nodiscard]] inline std::vector<RecordEvent> load_record(std::string_view filename)
+{
+	std::vector<RecordEvent> events;
+
+	std::ifstream in {std::string(filename), std::ios::binary};
+	if (!in.is_open())
+		return events;
+
+	RecordHeader header;
+	RecordHeader expected;
+
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (!in || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+		header.version != expected.version || header.event_size != sizeof(RecordEvent))
+		return events;
+
+	const auto bytes = std::filesystem::file_size(std::filesystem::path(filename)) - sizeof(header);
+
+	events.resize(bytes / sizeof(RecordEvent));
+	in.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(RecordEvent)));
+
+	return events;
+}
+
+
+#if MTP_ENABLE_RECORD
+
+
+class AllocRecorder
+{
+public:
+
+	static constexpr bool enabled = true;
+
+	AllocRecorder() = delete;
+
+	static void open(std::string_view filename)
+	{
+		const auto parent = std::filesystem::path(filename).parent_path();
+
+		if (!parent.empty())
+			std::filesystem::create_directories(parent);
+
+		std::lock_guard lock {state().mutex};
+
+		auto& log = state();
+
+		log.out.close();
+		log.out.open(std::string(filename), std::ios::binary | std::ios::trunc);
+
+		log.live.clear();
+		log.sources.clear();
+		log.buffer.clear();
+		log.next_handle = 0;
+
+		if (!log.out.is_open())
+			return;
+
+		RecordHeader header;
+		header.event_size = sizeof(RecordEvent);
+
+		log.out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		active.store(true, std::memory_order_release);
+	}
+
+	static void close()
+	{
+		std::lock_guard lock {state().mutex};
+
+		active.store(false, std::memory_order_release);
+
+		flush(state());
+		state().out.close();
+	}
+
+	static void record_alloc(const void* source, const std::byte* block, uint32_t size, uint32_t alignment, uint16_t proxy)
+	{
+		if (!active.load(std::memory_order_relaxed) || block == nullptr) [[likely]]
+			return;
+
+		std::lock_guard lock {state().mutex};
+
+		auto& log = state();
+
+		const uint8_t source_id = source_of(log, source);
+		const uint64_t handle   = log.next_handle++;
+
+		log.live[block] = {handle, source_id};
+
+		append(log, {RecordKind::alloc, source_id, proxy, thread_id(), size, alignment, handle});
+	}
+
+	static void record_free(const void* source, const std::byte* block)
+	{
+		if (!active.load(std::memory_order_relaxed)) [[likely]]
+			return;
+
+		std::lock_guard lock {state().mutex};
+
+		auto& log = state();
+
+		// blocks allocated before recording started have no handle and are left out
+
+		const auto found = log.live.find(block);
+		if (found == log.live.end())
+			return;
+
+		const uint64_t handle = found->second.handle;
+		log.live.erase(found);
+
+		append(log, {RecordKind::free, source_of(log, source), 0, thread_id(), 0, 0, handle});
+	}
+
+	static void record_reset(const void* source)
+	{
+		if (!active.load(std::memory_order_relaxed)) [[likely]]
+			return;
+
+		std::lock_guard lock {state().mutex};
+
+		auto& log = state();
+
+		const uint8_t source_id = source_of(log, source);
+
+		std::erase_if(log.live, [source_id](const auto& entry) { return entry.second.source == source_id; });
+
+		append(log, {RecordKind::reset, source_id, 0, thread_id(), 0, 0, 0});
+	}
+
+	// a partial reset drops only some of the source's blocks, they are logged as frees so a replay
+	// keeps the blocks of the untouched strides live
+
+	template <typename Dropped>
+	static void record_reset_blocks(const void* source, Dropped&& dropped)
+	{
+		if (!active.load(std::memory_order_relaxed)) [[likely]]
+			return;
+
+		std::lock_guard lock {state().mutex};
+
+		auto& log = state();
+
+		const uint8_t source_id = source_of(log, source);
+
+		for (auto entry = log.live.begin(); entry != log.live.end();) {
+			if (entry->second.source != source_id || !dropped(entry->first)) {
+				++entry;
+				continue;
+			}
+
+			append(log, {RecordKind::free, source_id, 0, thread_id(), 0, 0, entry->second.handle});
+
+			entry = log.live.erase(entry);
+		}
+	}
+
+private:
+
+	struct Live
+	{
+		uint64_t handle;
+		uint8_t  source;
+	};
+
+	struct State
+	{
+		std::mutex    mutex;
+		std::ofstream out;
+
+		std::unordered_map<const std::byte*, Live>  live;
+		std::unordered_map<const void*, uint8_t>    sources;
+
+		std::vector<RecordEvent> buffer;
+
+		uint64_t next_handle {0};
+	};
+
+	static constexpr size_t buffer_events = 16384;
+
+	static State& state() noexcept
+	{
+		static State instance;
+		return instance;
+	}
+
+	static uint8_t source_of(State& log, const void* source)
+	{
+		const auto [entry, inserted] = log.sources.try_emplace(source, static_cast<uint8_t>(std::min<size_t>(log.sources.size(), 255U)));
+		return entry->second;
+	}
+
+	static void append(State& log, const RecordEvent& event)
+	{
+		log.buffer.push_back(event);
+
+		if (log.buffer.size() >= buffer_events)
+			flush(log);
+	}
+
+	static void flush(State& log)
+	{
+		if (log.out.is_open() && !log.buffer.empty())
+			log.out.write(reinterpret_cast<const char*>(log.buffer.data()),
+				static_cast<std::streamsize>(log.buffer.size() * sizeof(RecordEvent)));
+
+		log.buffer.clear();
+	}
+
+	static uint32_t thread_id() noexcept
+	{
+		thread_local const uint32_t id = next_thread.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+	static inline std::atomic<bool>     active      {false};
+	static inline std::atomic<uint32_t> next_thread {0};
+};
+
+#else
+
+class AllocRecorder
+{
+public:
+	static constexpr bool enabled = false;
+
+	static inline void open(std::string_view) noexcept {}
+	static inline void close() noexcept {}
+	static inline void record_alloc(const void*, const std::byte*, uint32_t, uint32_t, uint16_t) noexcept {}
+	static inline void record_free(const void*, const std::byte*) noexcept {}
+	static inline void record_reset(const void*) noexcept {}
+
+	template <typename Dropped>
+	static inline void record_reset_blocks(const void*, Dropped&&) noexcept {}
+};
+
+#endif
+
+} // mtp::cfg
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <new>
+#include <atomic>
+
+
+namespace mtp::core {
+
+
+// per-proxy counters kept in the allocator instance next to its freelist heads
+// in_use counts blocks handed out and not yet returned, cached magazine blocks included
+// a fallback is an allocation served by a larger stride, an exhaustion is a miss the stride could not serve itself
+
+struct ProxyCounters
+{
+	uint64_t in_use      {0};
+	uint64_t high_water  {0};
+	uint64_t fallbacks   {0};
+	uint64_t exhaustions {0};
+};
+
+
+// lock-free instances update relaxed atomics, one cache line per proxy
+
+struct alignas(std::hardware_destructive_interference_size) SharedCounters
+{
+	std::atomic<uint64_t> in_use      {0};
+	std::atomic<uint64_t> high_water  {0};
+	std::atomic<uint64_t> fallbacks   {0};
+	std::atomic<uint64_t> exhaustions {0};
+};
+
+
+// snapshot of one proxy, block_count is the configured capacity of the stride
+
+struct ProxyStats
+{
+	uint32_t stride      {0};
+	uint32_t block_count {0};
+
+	uint64_t in_use      {0};
+	uint64_t high_water  {0};
+	uint64_t fallbacks   {0};
+	uint64_t exhaustions {0};
+};
+
+} // mtp::core
@@ -2,9 +2,15 @@
 
 #include "mtpint.hpp"
 
+#include <map>
+#include <cmath>
 #include <array>
+#include <mutex>
+#include <atomic>
 #include <string>
+#include <vector>
 #include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
 #include <string_view>
@@ -18,6 +24,10 @@
 	#endif
 #endif
 
+#ifndef MTP_TRACE_SAMPLE_RATE
+	#define MTP_TRACE_SAMPLE_RATE 1
+#endif
+
 
 namespace mtp::cfg {
 
@@ -25,35 +35,47 @@ namespace mtp::cfg {
 #if MTP_ENABLE_TRACE
 
 
+// every thread records into its own open-addressing shard keyed by (raw_size, alignment, proxy)
+// shards are merged when the trace is exported and handed to the next thread when their owner exits
+// with a sample rate of N each traced allocation is recorded with probability 1/N and its counts are scaled by N,
+// fallbacks are rare and always recorded exactly
+
 class AllocTracer
 {
 public:
 
+	static constexpr bool enabled = true;
+
 	AllocTracer() = delete;
 
-	static void trace(uint32_t raw_size, uint32_t alignment, uint32_t stride, uint16_t proxy_index)
-	{
-		const int index = find_or_insert(raw_size, alignment, proxy_index);
-		if (index >= 0) {
-			auto& stat = stats[index];
-			++stat.count;
-			stat.raw_total_bytes += raw_size;
-			stat.stride_total_bytes += stride;
-		} else {
-			++overflow.count;
-			overflow.raw_total_bytes += raw_size;
-			overflow.stride_total_bytes += stride;
-		}
+	static void trace(uint32_t raw_size, uint32_t alignment, uint32_t stride, uint16_t proxy_index, uint32_t count = 1)
+	{
+		if (--countdown != 0) [[likely]]
+			return;
+
+		const uint32_t rate = sample_rate.load(std::memory_order_relaxed);
+
+		countdown = next_interval(rate);
+
+		const uint64_t scaled = static_cast<uint64_t>(count) * rate;
+
+		Stat& stat = local_shard().find_or_insert(raw_size, alignment, proxy_index);
+
+		add(stat.count, scaled);
+		add(stat.raw_total_bytes, static_cast<uint64_t>(raw_size) * scaled);
+		add(stat.stride_total_bytes, static_cast<uint64_t>(stride) * scaled);
 	}
 
 	static void trace_fallback(uint32_t raw_size, uint32_t alignment, uint16_t proxy_index)
 	{
-		const int index = find_or_insert(raw_size, alignment, proxy_index);
-		if (index >= 0) {
-			++stats[index].fallback_count;
-		} else {
-			++overflow.fallback_count;
-		}
+		add(local_shard().find_or_insert(raw_size, alignment, proxy_index).fallback_count, 1);
+	}
+
+	// 1 records every allocation; takes effect on each thread after its current sampling period
+
+	static void set_sample_rate(uint32_t rate) noexcept
+	{
+		sample_rate.store(std::max(rate, 1U), std::memory_order_relaxed);
 	}
 
 	static void export_trace(std::string_view filename, bool clear = false)
@@ -64,75 +86,330 @@ public:
 		if (!out.is_open())
 			return;
 
+		std::map<std::array<uint32_t, 3>, Totals> merged;
+		Totals overflow_totals;
+
+		{
+			std::lock_guard lock {registry().mutex};
+
+			for (Shard* shard : registry().shards) {
+				for (Entry& entry : shard->entries) {
+					if (entry.state.load(std::memory_order_acquire) == 0)
+						continue;
+
+					merged[{entry.raw_size, entry.alignment, entry.proxy_index}].merge(entry.stat, clear);
+				}
+
+				overflow_totals.merge(shard->overflow, clear);
+			}
+		}
+
 		out << "raw_size,alignment,proxy_index,count,fallbacks,raw_total_bytes,stride_total_bytes\n";
 
-		for (uint32_t i = 0; i < used; ++i) {
-			out << keys[i][0] << ','
-				<< keys[i][1] << ','
-				<< keys[i][2] << ','
-				<< stats[i].count << ','
-				<< stats[i].fallback_count << ','
-				<< stats[i].raw_total_bytes << ','
-				<< stats[i].stride_total_bytes << '\n';
+		for (const auto& [key, totals] : merged) {
+			if (totals.count == 0 && totals.fallback_count == 0)
+				continue;
+
+			out << key[0] << ','
+				<< key[1] << ','
+				<< key[2] << ','
+				<< totals.count << ','
+				<< totals.fallback_count << ','
+				<< totals.raw_total_bytes << ','
+				<< totals.stride_total_bytes << '\n';
 		}
 
-		if (overflow.count > 0 || overflow.fallback_count > 0) {
+		if (overflow_totals.count > 0 || overflow_totals.fallback_count > 0) {
 			out << "?,?,?,"
-				<< overflow.count << ','
-				<< overflow.fallback_count << ','
-				<< overflow.raw_total_bytes << ','
-				<< overflow.stride_total_bytes << '\n';
+				<< overflow_totals.count << ','
+				<< overflow_totals.fallback_count << ','
+				<< overflow_totals.raw_total_bytes << ','
+				<< overflow_totals.stride_total_bytes << '\n';
 		}
 
-		if (clear) {
-			used = 0;
-			overflow = {};
+		std::cout << "trace written: " << filename << '\n';
+
+		// sizes that arrived after a thread's table filled up have no key, so nothing downstream can size them
+
+		if (overflow_totals.count > 0 || overflow_totals.fallback_count > 0) {
+			std::cerr << "trace warning: " << overflow_totals.count << " allocations and "
+				<< overflow_totals.fallback_count << " fallbacks past the " << shard_limit
+				<< " keys of a thread's trace table are only in the unkeyed ? row\n";
 		}
+	}
 
-		std::cout << "trace written: " << filename << '\n';
+	// time-series mode: every frame mark appends one row per proxy that has been used so far,
+	// fallbacks and exhaustions are cumulative so a rise between two frames locates the spike
+
+	static void open_frames(std::string_view filename)
+	{
+		const auto parent = std::filesystem::path(filename).parent_path();
+
+		if (!parent.empty())
+			std::filesystem::create_directories(parent);
+
+		std::lock_guard lock {frames().mutex};
+
+		frames().out.close();
+		frames().out.open(std::string(filename), std::ios::trunc);
+		frames().index = 0;
+
+		if (frames().out.is_open())
+			frames().out << "frame,proxy_index,stride,block_count,in_use,high_water,fallbacks,exhaustions\n";
+	}
+
+	template <typename Stats>
+	static void frame_mark(const Stats& stats)
+	{
+		std::lock_guard lock {frames().mutex};
+
+		auto& stream = frames();
+
+		if (!stream.out.is_open())
+			return;
+
+		for (size_t i = 0; i < stats.size(); ++i) {
+			const auto& proxy = stats[i];
+
+			if (proxy.high_water == 0 && proxy.fallbacks == 0 && proxy.exhaustions == 0)
+				continue;
+
+			stream.out << stream.index << ','
+				<< i << ','
+				<< proxy.stride << ','
+				<< proxy.block_count << ','
+				<< proxy.in_use << ','
+				<< proxy.high_water << ','
+				<< proxy.fallbacks << ','
+				<< proxy.exhaustions << '\n';
+		}
+
+		++stream.index;
+	}
+
+	static void close_frames()
+	{
+		std::lock_guard lock {frames().mutex};
+
+		if (frames().out.is_open()) {
+			frames().out.close();
+			std::cout << "frames written: " << frames().index << '\n';
+		}
 	}
 
 private:
 
+	struct FrameStream
+	{
+		std::mutex    mutex;
+		std::ofstream out;
+		uint64_t      index {0};
+	};
+
+	static FrameStream& frames() noexcept
+	{
+		static FrameStream instance;
+		return instance;
+	}
+
+	// counters have a single writer, the owning thread; atomics only make the concurrent export well-defined
+	// a clearing export never writes them, it moves the exported baseline instead, kept under the registry mutex
+
 	struct Stat
 	{
-		uint32_t count;
-		uint32_t fallback_count;
-		uint64_t raw_total_bytes;
-		uint64_t stride_total_bytes;
-
-		Stat() noexcept
-			: count{0}
-			, fallback_count{0}
-			, raw_total_bytes{0}
-			, stride_total_bytes{0}
-		{}
+		std::atomic<uint64_t> count              {0};
+		std::atomic<uint64_t> fallback_count     {0};
+		std::atomic<uint64_t> raw_total_bytes    {0};
+		std::atomic<uint64_t> stride_total_bytes {0};
+
+		struct Baseline
+		{
+			uint64_t count              {0};
+			uint64_t fallback_count     {0};
+			uint64_t raw_total_bytes    {0};
+			uint64_t stride_total_bytes {0};
+		};
+
+		Baseline exported;
 	};
 
-	static constexpr uint32_t max_trace_entries = 32768;
+	struct Totals
+	{
+		uint64_t count              {0};
+		uint64_t fallback_count     {0};
+		uint64_t raw_total_bytes    {0};
+		uint64_t stride_total_bytes {0};
+
+		void merge(Stat& stat, bool clear) noexcept
+		{
+			count              += take(stat.count, stat.exported.count, clear);
+			fallback_count     += take(stat.fallback_count, stat.exported.fallback_count, clear);
+			raw_total_bytes    += take(stat.raw_total_bytes, stat.exported.raw_total_bytes, clear);
+			stride_total_bytes += take(stat.stride_total_bytes, stat.exported.stride_total_bytes, clear);
+		}
+
+		// counts since the last clearing export; an owner update racing the export shows up in the next one
+
+		static uint64_t take(const std::atomic<uint64_t>& value, uint64_t& baseline, bool clear) noexcept
+		{
+			const uint64_t current = value.load(std::memory_order_relaxed);
+			const uint64_t delta   = current - baseline;
+
+			if (clear)
+				baseline = current;
+
+			return delta;
+		}
+	};
+
+	// key fields are written once before the entry is published and never change afterwards
 
-	static int find_or_insert(uint32_t raw_size, uint32_t alignment, uint16_t proxy_index)
+	struct Entry
 	{
-		for (uint32_t i = 0; i < used; ++i) {
-			if (keys[i][0] == raw_size &&
-				keys[i][1] == alignment &&
-				keys[i][2] == proxy_index)
-				return static_cast<int>(i);
+		std::atomic<uint32_t> state {0};
+
+		uint32_t raw_size    {0};
+		uint32_t alignment   {0};
+		uint16_t proxy_index {0};
+
+		Stat stat;
+	};
+
+	static constexpr uint32_t shard_bits     = 13U;
+	static constexpr uint32_t shard_capacity = 1U << shard_bits;
+	static constexpr uint32_t shard_limit    = shard_capacity / 4U * 3U;
+
+	struct Shard
+	{
+		std::array<Entry, shard_capacity> entries {};
+
+		Stat overflow;
+
+		uint32_t used {0};
+
+		Stat& find_or_insert(uint32_t raw_size, uint32_t alignment, uint16_t proxy_index) noexcept
+		{
+			const uint64_t key =
+				(static_cast<uint64_t>(raw_size) << 32) ^
+				(static_cast<uint64_t>(alignment) << 16) ^
+				proxy_index;
+
+			uint32_t slot = static_cast<uint32_t>((key * 0x9E37'79B9'7F4A'7C15ULL) >> (64U - shard_bits));
+
+			for (;; slot = (slot + 1U) & (shard_capacity - 1U)) {
+				Entry& entry = entries[slot];
+
+				if (entry.state.load(std::memory_order_relaxed) == 0) {
+					if (used >= shard_limit) [[unlikely]]
+						return overflow;
+
+					entry.raw_size    = raw_size;
+					entry.alignment   = alignment;
+					entry.proxy_index = proxy_index;
+					entry.state.store(1, std::memory_order_release);
+
+					++used;
+					return entry.stat;
+				}
+
+				if (entry.raw_size == raw_size && entry.alignment == alignment && entry.proxy_index == proxy_index)
+					return entry.stat;
+			}
 		}
+	};
+
+	struct Registry
+	{
+		std::mutex mutex;
 
-		if (used < max_trace_entries) {
-			keys[used] = { raw_size, alignment, proxy_index };
-			stats[used] = Stat{};
-			return static_cast<int>(used++);
+		std::vector<Shard*> shards;
+		std::vector<Shard*> idle;
+
+		~Registry()
+		{
+			for (Shard* shard : shards)
+				delete shard;
 		}
+	};
+
+	// a thread keeps its shard until it exits, then the shard and its counts wait for the next thread
 
-		return -1;
+	struct ShardLease
+	{
+		Shard* shard {nullptr};
+
+		~ShardLease()
+		{
+			if (shard == nullptr)
+				return;
+
+			std::lock_guard lock {registry().mutex};
+			registry().idle.push_back(shard);
+		}
+	};
+
+	static Registry& registry() noexcept
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	static Shard& local_shard()
+	{
+		thread_local ShardLease lease;
+
+		if (lease.shard == nullptr) [[unlikely]] {
+			std::lock_guard lock {registry().mutex};
+
+			if (!registry().idle.empty()) {
+				lease.shard = registry().idle.back();
+				registry().idle.pop_back();
+			}
+			else {
+				lease.shard = new Shard {};
+				registry().shards.push_back(lease.shard);
+			}
+		}
+
+		return *lease.shard;
+	}
+
+	// geometric gap with mean rate, drawn from a per-thread xorshift: a fixed countdown aliases with
+	// allocation patterns whose period divides the rate, a memoryless gap keeps the scaled counts unbiased
+
+	static uint32_t next_interval(uint32_t rate) noexcept
+	{
+		if (rate == 1)
+			return 1;
+
+		uint64_t state = rng_state;
+
+		if (state == 0) [[unlikely]]
+			state = (reinterpret_cast<std::uintptr_t>(&rng_state) * 0x9E3779B97F4A7C15ULL) | 1U;
+
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		rng_state = state;
+
+		const double uniform = (static_cast<double>(state >> 11) + 1.0) * 0x1.0p-53;
+		const double gap     = std::floor(std::log(uniform) / std::log1p(-1.0 / rate)) + 1.0;
+
+		return static_cast<uint32_t>(std::min(gap, 4294967295.0));
+	}
+
+	static void add(std::atomic<uint64_t>& value, uint64_t delta) noexcept
+	{
+		value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
 	}
 
-	static inline std::array<std::array<uint32_t, 3>, max_trace_entries> keys {};
-	static inline std::array<Stat, max_trace_entries> stats {};
-	static inline uint32_t used = 0;
-	static inline Stat overflow {};
+	static inline std::atomic<uint32_t> sample_rate {MTP_TRACE_SAMPLE_RATE};
+
+	// trivially initialized, so the sampling check on the hot path needs no thread_local guard
+
+	static inline thread_local uint32_t countdown {1};
+	static inline thread_local uint64_t rng_state {0};
 };
 
 #else
@@ -140,9 +417,16 @@ private:
 class AllocTracer
 {
 public:
-	static inline void trace(uint32_t, uint32_t, uint32_t, uint16_t) noexcept {}
+	static constexpr bool enabled = false;
+
+	static inline void trace(uint32_t, uint32_t, uint32_t, uint16_t, uint32_t = 1) noexcept {}
 	static inline void trace_fallback(uint32_t, uint32_t, uint16_t) noexcept {}
+	static inline void set_sample_rate(uint32_t) noexcept {}
 	static inline void export_trace(std::string_view = {}, bool = false) noexcept {}
+	static inline void open_frames(std::string_view) noexcept {}
+	template <typename Stats>
+	static inline void frame_mark(const Stats&) noexcept {}
+	static inline void close_frames() noexcept {}
 };
 
 #endif
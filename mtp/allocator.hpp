@@ -2,14 +2,26 @@
 
 #include "mtpint.hpp"
 
+#include <bit>
+#include <array>
 #include <span>
+#include <atomic>
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
 
 #include <memory_resource>
 
+#include "alloc_stats.hpp"
+#include "alloc_recorder.hpp"
 #include "alloc_tracer.hpp"
+#include "freelist.hpp"
+#include "page_map.hpp"
+#include "remote_queue.hpp"
+#include "overflow_arena.hpp"
 #include "freelist_proxy.hpp"
 #include "allocator_config.hpp"
+#include "size_class_table.hpp"
 
 #include "fail.hpp"
 
@@ -22,6 +34,10 @@ struct StdAdapter {};
 struct PmrAdapter {};
 
 
+template <typename Set>
+class MagazineCache;
+
+
 template <mtp::cfg::IsAllocatorConfig Config>
 class AllocatorCore
 {
@@ -30,11 +46,45 @@ class AllocatorCore
 
 public:
 
+	using config_type   = Config;
 	using proxy_index_t = decltype(Config::range_metadata[0].base_proxy_index);
 
-	constexpr AllocatorCore(std::span<FreelistProxy> proxies)
-		: m_proxies {proxies}
-	{}
+	// concurrent configs keep one tagged lock-free stack per stride, everything else a plain head pointer
+
+	using head_t = std::conditional_t<Config::concurrent, SharedHead, FreeBlock*>;
+
+	using counters_t = std::conditional_t<Config::concurrent, SharedCounters, ProxyCounters>;
+
+	using stats_t = std::array<ProxyStats, Config::total_stride_count>;
+
+	using remote_queue_t = RemoteQueue<std::remove_cvref_t<Config>>;
+
+	constexpr AllocatorCore(
+		std::span<head_t>        heads,
+		std::span<counters_t>    counters,
+		std::span<uint64_t>      occupancy,
+		std::span<FreelistProxy> proxies,
+		PageMap                  pages    = {},
+		OverflowArena*           overflow = nullptr,
+		std::byte*               base     = nullptr,
+		remote_queue_t*          remote   = nullptr
+	)
+		: m_heads     {heads}
+		, m_counters  {counters}
+		, m_occupancy {occupancy}
+		, m_proxies   {proxies}
+		, m_pages     {pages}
+		, m_overflow  {overflow}
+		, m_base      {base}
+		, m_remote    {remote}
+	{
+		MTP_ASSERT(!Config::elastic || overflow != nullptr,
+			mtp::err::core_overflow_null);
+		MTP_ASSERT(!Config::concurrent || base != nullptr,
+			mtp::err::core_base_null);
+
+		sync_occupancy();
+	}
 
 	AllocatorCore() = delete;
 	virtual ~AllocatorCore() = default;
@@ -57,21 +107,12 @@ public:
 		MTP_ASSERT(proxy_index < Config::total_stride_count,
 			mtp::err::alloc_proxy_oob);
 
-		std::byte* block = m_proxies[proxy_index].fetch();
-
-		while (block == nullptr) [[unlikely]] {
+		std::byte* block = pop(proxy_index);
 
-			mtp::cfg::AllocTracer::trace_fallback(size, alignment, proxy_index);
-
-			if (++proxy_index >= Config::total_stride_count) [[unlikely]] {
+		if (block == nullptr) [[unlikely]]
+			block = fetch_fallback(size, alignment, proxy_index, mtp::err::alloc_proxy_oob);
 
-				fatal(mtp::err::alloc_proxy_oob,
-					mtp::err::format_ctx("size = %u, align = %u, proxy = %u / %u",
-						size, alignment, proxy_index, Config::total_stride_count - 1));
-			}
-
-			block = m_proxies[proxy_index].fetch();
-		}
+		mtp::cfg::AllocRecorder::record_alloc(m_heads.data(), block, size, alignment, proxy_index);
 
 		return block;
 	}
@@ -82,16 +123,124 @@ public:
 		if (block == nullptr) [[unlikely]]
 			return;
 
-		const std::byte* header = block - sizeof(proxy_index_t);
-	
-		const proxy_index_t proxy_index =
-			static_cast<proxy_index_t>(header[0]) |
-			(static_cast<proxy_index_t>(header[1]) << 8);
+		mtp::cfg::AllocRecorder::record_free(m_heads.data(), block);
+
+		if (is_foreign(block)) [[unlikely]] {
+			free_remote(block);
+			return;
+		}
+
+		const proxy_index_t proxy_index = proxy_of(block);
 
 		MTP_ASSERT(proxy_index < Config::total_stride_count,
 			mtp::err::free_proxy_oob);
 
-		m_proxies[proxy_index].release(block);
+		push(proxy_index, block);
+	}
+
+
+	[[nodiscard]] inline std::byte* try_alloc(uint32_t size, uint32_t alignment) noexcept
+	{
+		MTP_ASSERT(size > 0,
+			mtp::err::alloc_zero_size);
+
+		const proxy_index_t proxy_index = resolve_unchecked(size, alignment);
+
+		if (proxy_index >= Config::total_stride_count) [[unlikely]]
+			return nullptr;
+
+		mtp::cfg::AllocTracer::trace(size, alignment, Config::proxy_strides[proxy_index], proxy_index);
+
+		std::byte* block = pop(proxy_index);
+
+		if (block == nullptr) [[unlikely]]
+			block = try_fetch_fallback(size, alignment, proxy_index);
+
+		mtp::cfg::AllocRecorder::record_alloc(m_heads.data(), block, size, alignment, proxy_index);
+
+		return block;
+	}
+
+
+	inline void alloc_batch(uint32_t size, uint32_t alignment, size_t count, std::byte** out)
+	{
+		MTP_ASSERT(size > 0,
+			mtp::err::alloc_zero_size);
+		MTP_ASSERT(out != nullptr || count == 0,
+			mtp::err::alloc_batch_out_null);
+
+		const proxy_index_t requested = resolve(size, alignment);
+
+		MTP_ASSERT(requested < Config::total_stride_count,
+			mtp::err::alloc_proxy_oob);
+
+		mtp::cfg::AllocTracer::trace(size, alignment, Config::proxy_strides[requested], requested,
+			static_cast<uint32_t>(count));
+
+		size_t filled = take_run(requested, count, out);
+
+		if (filled < count) [[unlikely]]
+			filled += fill_fallback(size, alignment, requested, count - filled, out + filled);
+
+		if constexpr (mtp::cfg::AllocRecorder::enabled) {
+			for (size_t i = 0; i < count; ++i)
+				mtp::cfg::AllocRecorder::record_alloc(m_heads.data(), out[i], size, alignment, requested);
+		}
+	}
+
+
+	inline void free_batch(std::byte* const* blocks, size_t count)
+	{
+		MTP_ASSERT(blocks != nullptr || count == 0,
+			mtp::err::free_batch_blocks_null);
+
+		// blocks are linked into one local run per stride and every run is spliced with a single head update,
+		// so interleaved strides cost one splice each; the run table is direct-mapped by proxy index and a
+		// colliding stride flushes the run it displaces, which only splits runs when there are more strides than slots
+
+		std::array<BatchRun, batch_run_slots> runs {};
+
+		for (size_t i = 0; i < count; ++i) {
+			std::byte* block = blocks[i];
+
+			if (block == nullptr) [[unlikely]]
+				continue;
+
+			mtp::cfg::AllocRecorder::record_free(m_heads.data(), block);
+
+			if (is_foreign(block)) [[unlikely]] {
+				free_remote(block);
+				continue;
+			}
+
+			const proxy_index_t proxy_index = proxy_of(block);
+
+			MTP_ASSERT(proxy_index < Config::total_stride_count,
+				mtp::err::free_proxy_oob);
+			MTP_ASSERT(Config::elastic || m_proxies[proxy_index].owns(block),
+				mtp::err::release_block_outside);
+
+			auto* node = reinterpret_cast<FreeBlock*>(block);
+
+			BatchRun& run = runs[proxy_index & (batch_run_slots - 1U)];
+
+			if (run.first != nullptr && run.proxy == proxy_index) [[likely]] {
+				run.last->next = node;
+				run.last = node;
+				++run.count;
+				continue;
+			}
+
+			if (run.first != nullptr)
+				splice(run.proxy, run.first, run.last, run.count);
+
+			run = BatchRun {node, node, 1, proxy_index};
+		}
+
+		for (BatchRun& run : runs) {
+			if (run.first != nullptr)
+				splice(run.proxy, run.first, run.last, run.count);
+		}
 	}
 
 
@@ -104,22 +253,26 @@ public:
 		constexpr uint32_t size = sizeof(T);
 		constexpr uint32_t alignment = alignof(T);
 
-		proxy_index_t proxy_index = lookup(size, alignment);
-		std::byte* block = m_proxies[proxy_index].fetch();
+		std::byte* block = fetch_static<size, alignment>();
 
-		while (block == nullptr) [[unlikely]] {
+		T* object = std::launder(new (block) T(std::forward<Types>(args)...));
+		return object;
+	}
 
-			mtp::cfg::AllocTracer::trace_fallback(size, alignment, proxy_index);
 
-			if (++proxy_index >= Config::total_stride_count) [[unlikely]] {
+	template <typename T, typename... Types>
+	[[nodiscard]] inline T* try_construct(Types&&... args)
+	{
+		MTP_ASSERT(sizeof(T) > 0,
+			mtp::err::zero_size_construct);
 
-				fatal(mtp::err::construct_proxy_oob,
-					mtp::err::format_ctx("size = %u, align = %u, proxy = %u / %u",
-						size, alignment, proxy_index, Config::total_stride_count - 1));
-			}
+		constexpr uint32_t size = sizeof(T);
+		constexpr uint32_t alignment = alignof(T);
 
-			block = m_proxies[proxy_index].fetch();
-		}
+		std::byte* block = try_fetch_static<size, alignment>();
+
+		if (block == nullptr) [[unlikely]]
+			return nullptr;
 
 		T* object = std::launder(new (block) T(std::forward<Types>(args)...));
 		return object;
@@ -135,22 +288,7 @@ public:
 		constexpr uint32_t size = (sizeof(T) + ForceAlign - 1) & ~(ForceAlign - 1);
 		constexpr uint32_t alignment = ForceAlign;
 
-		proxy_index_t proxy_index = lookup(size, alignment);
-		std::byte* block = m_proxies[proxy_index].fetch();
-
-		while (block == nullptr) [[unlikely]] {
-
-			mtp::cfg::AllocTracer::trace_fallback(size, alignment, proxy_index);
-
-			if (++proxy_index >= Config::total_stride_count) [[unlikely]] {
-
-				fatal(mtp::err::construct_proxy_oob,
-					mtp::err::format_ctx("size = %u, align = %u, proxy = %u / %u",
-						size, alignment, proxy_index, Config::total_stride_count - 1));
-			}
-
-			block = m_proxies[proxy_index].fetch();
-		}
+		std::byte* block = fetch_static<size, alignment>();
 
 		T* object = std::launder(new (block) T(std::forward<Types>(args)...));
 		return object;
@@ -163,75 +301,817 @@ public:
 		if (object == nullptr) [[unlikely]]
 			return;
 
-		const std::byte* header = reinterpret_cast<std::byte*>(object) - sizeof(proxy_index_t);
-	
-		const proxy_index_t proxy_index =
-			static_cast<proxy_index_t>(header[0]) |
-			(static_cast<proxy_index_t>(header[1]) << 8);
+		mtp::cfg::AllocRecorder::record_free(m_heads.data(), reinterpret_cast<std::byte*>(object));
+
+		if (is_foreign(reinterpret_cast<std::byte*>(object))) [[unlikely]] {
+			object->~T();
+			free_remote(reinterpret_cast<std::byte*>(object));
+			return;
+		}
+
+		const proxy_index_t proxy_index = proxy_of(reinterpret_cast<std::byte*>(object));
 
 		MTP_ASSERT(proxy_index < Config::total_stride_count,
 			mtp::err::destruct_proxy_oob);
 
 		object->~T();
 
-		m_proxies[proxy_index].release(reinterpret_cast<std::byte*>(object));
+		push(proxy_index, reinterpret_cast<std::byte*>(object));
 	}
 
+	// not synchronized: a concurrent allocator must be quiescent while it is reset
+
 	inline void reset() noexcept
 	{
-		for (auto& proxy : m_proxies) {
-			proxy.reset();
+		mtp::cfg::AllocRecorder::record_reset(m_heads.data());
+
+		if constexpr (Config::elastic)
+			m_overflow->reset();
+
+		// blocks returned by other threads are rewound with the rest of the arena
+
+		if (m_remote != nullptr)
+			static_cast<void>(m_remote->take());
+
+		for (size_t index = 0; index < m_heads.size(); ++index)
+			reset_proxy(index);
+
+		sync_occupancy();
+	}
+
+	// drops the blocks of one metapool, by declaration index in the metaset, and keeps every other freelist
+	// with its live blocks; same synchronization rules as reset()
+
+	template <size_t Index>
+	inline void reset_metapool() noexcept
+	{
+		static_assert(Index < Config::range_count,
+			CORE_METAPOOL_INDEX_MSG);
+
+		constexpr auto& range = Config::range_metadata[Config::metapool_order[Index]];
+
+		constexpr size_t first = range.base_proxy_index;
+		constexpr size_t last  = first + range.stride_count;
+
+		reset_selected([](size_t index) { return index >= first && index < last; });
+	}
+
+	// drops the blocks of every stride in [stride_lo, stride_hi], whichever metapools they belong to
+
+	inline void reset_range(uint32_t stride_lo, uint32_t stride_hi) noexcept
+	{
+		reset_selected([stride_lo, stride_hi](size_t index) {
+			return Config::proxy_strides[index] >= stride_lo && Config::proxy_strides[index] <= stride_hi;
+		});
+	}
+
+	// blocks still handed out once the queued remote frees are taken back
+
+	[[nodiscard]] inline uint64_t live_blocks() noexcept
+	{
+		static_cast<void>(drain_remote());
+
+		uint64_t live = 0;
+
+		for (size_t index = 0; index < Config::total_stride_count; ++index) {
+			if constexpr (Config::concurrent)
+				live += m_counters[index].in_use.load(std::memory_order_relaxed);
+			else
+				live += m_counters[index].in_use;
 		}
+
+		return live;
+	}
+
+	// relaxed snapshot: on a lock-free instance the counters of different proxies are read at different times
+
+	[[nodiscard]] inline stats_t stats() const noexcept
+	{
+		stats_t snapshot {};
+
+		for (size_t index = 0; index < Config::total_stride_count; ++index) {
+			auto& entry = snapshot[index];
+
+			entry.stride      = Config::proxy_strides[index];
+			entry.block_count = Config::proxy_block_counts[index];
+
+			if constexpr (Config::concurrent) {
+				entry.in_use      = m_counters[index].in_use.load(std::memory_order_relaxed);
+				entry.high_water  = m_counters[index].high_water.load(std::memory_order_relaxed);
+				entry.fallbacks   = m_counters[index].fallbacks.load(std::memory_order_relaxed);
+				entry.exhaustions = m_counters[index].exhaustions.load(std::memory_order_relaxed);
+			}
+			else {
+				entry.in_use      = m_counters[index].in_use;
+				entry.high_water  = m_counters[index].high_water;
+				entry.fallbacks   = m_counters[index].fallbacks;
+				entry.exhaustions = m_counters[index].exhaustions;
+			}
+		}
+
+		return snapshot;
 	}
 
 private:
 
+	// one pending run of free_batch, slots are a power of two no larger than needed to give every stride its own
+
+	struct BatchRun
+	{
+		FreeBlock*    first {nullptr};
+		FreeBlock*    last  {nullptr};
+		size_t        count {0};
+		proxy_index_t proxy {0};
+	};
+
+	static constexpr size_t batch_run_slots = std::bit_ceil(std::min<size_t>(Config::total_stride_count, 32U));
+
+	template <uint32_t Size, uint32_t Alignment>
+	[[nodiscard]] inline std::byte* fetch_static()
+	{
+		constexpr proxy_index_t proxy_index = resolve(Size, Alignment);
+
+		static_assert(proxy_index != mtp::cfg::SizeClassConstraints::invalid_proxy,
+			CORE_CONSTRUCT_NO_MATCH_MSG);
+
+		mtp::cfg::AllocTracer::trace(Size, Alignment, Config::proxy_strides[proxy_index], proxy_index);
+
+		std::byte* block = pop(proxy_index);
+
+		if (block == nullptr) [[unlikely]]
+			block = fetch_fallback(Size, Alignment, proxy_index, mtp::err::construct_proxy_oob);
+
+		mtp::cfg::AllocRecorder::record_alloc(m_heads.data(), block, Size, Alignment, proxy_index);
+
+		return block;
+	}
+
+	template <uint32_t Size, uint32_t Alignment>
+	[[nodiscard]] inline std::byte* try_fetch_static() noexcept
+	{
+		constexpr proxy_index_t proxy_index = resolve(Size, Alignment);
+
+		static_assert(proxy_index != mtp::cfg::SizeClassConstraints::invalid_proxy,
+			CORE_CONSTRUCT_NO_MATCH_MSG);
+
+		mtp::cfg::AllocTracer::trace(Size, Alignment, Config::proxy_strides[proxy_index], proxy_index);
+
+		std::byte* block = pop(proxy_index);
+
+		if (block == nullptr) [[unlikely]]
+			block = try_fetch_fallback(Size, Alignment, proxy_index);
+
+		mtp::cfg::AllocRecorder::record_alloc(m_heads.data(), block, Size, Alignment, proxy_index);
+
+		return block;
+	}
+
+	inline std::byte* fetch_fallback(uint32_t size, uint32_t alignment, proxy_index_t proxy_index, const mtp::err::msg& oob)
+	{
+		std::byte* block = try_fetch_fallback(size, alignment, proxy_index);
+
+		if (block == nullptr) [[unlikely]] {
+
+			fatal(oob,
+				mtp::err::format_ctx("size = %u, align = %u, proxy = %u / %u",
+					size, alignment, proxy_index, Config::total_stride_count - 1));
+		}
+
+		return block;
+	}
+
+	// miss path: carve a never-used block, refill elastic sets, then fall back to a larger stride
+
+	inline std::byte* try_fetch_fallback(uint32_t size, uint32_t alignment, proxy_index_t proxy_index) noexcept
+	{
+		if (drain_remote()) {
+			if (std::byte* block = pop(proxy_index))
+				return block;
+		}
+
+		if (std::byte* block = carve(proxy_index)) [[likely]]
+			return block;
+
+		if constexpr (Config::elastic) {
+			if (refill(proxy_index)) [[likely]]
+				return carve(proxy_index);
+		}
+
+		mtp::cfg::AllocTracer::trace_fallback(size, alignment, proxy_index);
+
+		count_exhaustion(proxy_index);
+
+		mark_empty(proxy_index);
+
+		for (
+			size_t next_index = next_occupied(proxy_index);
+			next_index < Config::total_stride_count;
+			next_index = next_occupied(static_cast<proxy_index_t>(next_index))
+		) {
+			const auto next_proxy = static_cast<proxy_index_t>(next_index);
+
+			if (std::byte* block = take(next_proxy)) [[likely]] {
+				count_fallback(proxy_index, 1);
+				return block;
+			}
+
+			mark_empty(next_proxy);
+		}
+
+		return nullptr;
+	}
+
+	// batch miss path, the same order as the single-block one: drain and refill only the requested stride and
+	// charge it the exhaustion, then take whole runs from larger strides without refilling them
+
+	inline size_t fill_fallback(uint32_t size, uint32_t alignment, proxy_index_t requested, size_t count, std::byte** out)
+	{
+		size_t filled = 0;
+
+		if (drain_remote())
+			filled += take_run(requested, count, out);
+
+		if constexpr (Config::elastic) {
+			while (filled < count && refill(requested))
+				filled += take_run(requested, count - filled, out + filled);
+		}
+
+		if (filled == count)
+			return filled;
+
+		mtp::cfg::AllocTracer::trace_fallback(size, alignment, requested);
+
+		count_exhaustion(requested);
+
+		mark_empty(requested);
+
+		for (
+			size_t next_index = next_occupied(requested);
+			next_index < Config::total_stride_count;
+			next_index = next_occupied(static_cast<proxy_index_t>(next_index))
+		) {
+			const auto next_proxy = static_cast<proxy_index_t>(next_index);
+			const size_t taken    = take_run(next_proxy, count - filled, out + filled);
+
+			count_fallback(requested, taken);
+
+			filled += taken;
+
+			if (filled == count)
+				return filled;
+
+			mark_empty(next_proxy);
+		}
+
+		fatal(mtp::err::alloc_proxy_oob,
+			mtp::err::format_ctx("size = %u, align = %u, proxy = %u / %u",
+				size, alignment, requested, Config::total_stride_count - 1));
+	}
+
+	inline bool refill(proxy_index_t proxy_index) noexcept
+	{
+		const uint32_t stride = Config::proxy_strides[proxy_index];
+		const uint32_t count  = Config::elastic_chunk_blocks[proxy_index];
+
+		std::byte* memory = m_overflow->fetch(
+			static_cast<size_t>(stride) * count,
+			mtp::cfg::MetapoolConstraints::block_alignment(stride),
+			sizeof(proxy_index_t)
+		);
+
+		if (memory == nullptr) [[unlikely]]
+			return false;
+
+		m_proxies[proxy_index].extend(memory, static_cast<size_t>(stride) * count);
+		mark_occupied(proxy_index);
+
+		return true;
+	}
+
+	// one bit per proxy, set while its freelist may still hand out a block
+	// bits are set eagerly on push and cleared lazily once the fallback finds a stride exhausted
+
+	[[nodiscard]] inline size_t next_occupied(proxy_index_t proxy_index) const noexcept
+	{
+		const size_t first = static_cast<size_t>(proxy_index) + 1U;
+
+		size_t word_index = first >> 6;
+
+		if (word_index >= m_occupancy.size()) [[unlikely]]
+			return Config::total_stride_count;
+
+		uint64_t word = occupancy_word(word_index) & (~uint64_t{0} << (first & 63U));
+
+		while (word == 0) {
+			if (++word_index >= m_occupancy.size())
+				return Config::total_stride_count;
+
+			word = occupancy_word(word_index);
+		}
+
+		return (word_index << 6) + static_cast<size_t>(std::countr_zero(word));
+	}
+
+	// a concurrent push may land between the failed take and the clear, so the bit is restored
+	// when the stride turns out not to be exhausted after all
+
+	inline void mark_empty(proxy_index_t proxy_index) noexcept
+	{
+		const uint64_t bit = uint64_t{1} << (proxy_index & 63U);
+
+		if constexpr (Config::concurrent) {
+			std::atomic_ref<uint64_t>{m_occupancy[proxy_index >> 6]}.fetch_and(~bit, std::memory_order_acq_rel);
+
+			if (!head_empty(proxy_index) || m_proxies[proxy_index].can_carve_shared())
+				mark_occupied(proxy_index);
+		}
+		else {
+			m_occupancy[proxy_index >> 6] &= ~bit;
+		}
+	}
+
+	inline void mark_occupied(proxy_index_t proxy_index) noexcept
+	{
+		const uint64_t bit = uint64_t{1} << (proxy_index & 63U);
+
+		if constexpr (Config::concurrent)
+			std::atomic_ref<uint64_t>{m_occupancy[proxy_index >> 6]}.fetch_or(bit, std::memory_order_acq_rel);
+		else
+			m_occupancy[proxy_index >> 6] |= bit;
+	}
+
+	[[nodiscard]] inline uint64_t occupancy_word(size_t word_index) const noexcept
+	{
+		if constexpr (Config::concurrent)
+			return std::atomic_ref<uint64_t>{m_occupancy[word_index]}.load(std::memory_order_relaxed);
+		else
+			return m_occupancy[word_index];
+	}
+
+	inline void reset_proxy(size_t index) noexcept
+	{
+		if constexpr (Config::concurrent) {
+			m_heads[index].top.store(0, std::memory_order_relaxed);
+			m_counters[index].in_use.store(0, std::memory_order_relaxed);
+		}
+		else {
+			m_heads[index] = nullptr;
+			m_counters[index].in_use = 0;
+		}
+
+		m_proxies[index].reset();
+	}
+
+	// queued remote frees go back to their own freelists first, so the kept strides do not lose them;
+	// overflow chunks taken by the dropped strides stay mapped and are reclaimed by the next full reset
+
+	template <typename Selected>
+	inline void reset_selected(Selected selected) noexcept
+	{
+		static_cast<void>(drain_remote());
+
+		mtp::cfg::AllocRecorder::record_reset_blocks(m_heads.data(), [this, &selected](const std::byte* block) {
+			return selected(proxy_of(block));
+		});
+
+		for (size_t index = 0; index < m_heads.size(); ++index) {
+			if (selected(index))
+				reset_proxy(index);
+		}
+
+		sync_occupancy();
+	}
+
+	inline void sync_occupancy() noexcept
+	{
+		for (auto& word : m_occupancy)
+			word = 0;
+
+		for (size_t index = 0; index < m_heads.size(); ++index) {
+			const auto proxy_index = static_cast<proxy_index_t>(index);
+
+			const bool can_carve = Config::concurrent
+				? m_proxies[index].can_carve_shared()
+				: m_proxies[index].can_carve();
+
+			if (!head_empty(proxy_index) || can_carve)
+				mark_occupied(proxy_index);
+		}
+	}
+
+	// concurrent heads pack a generation tag above the block offset; every successful exchange bumps the tag
+
+	static constexpr uint64_t head_offset_mask = 0xFFFF'FFFFULL;
+	static constexpr uint32_t head_tag_shift   = 32U;
+	static constexpr uint32_t quantum_shift    = std::countr_zero(Config::alignment_quantum);
+
+	[[nodiscard]] inline FreeBlock* decode(uint64_t top) const noexcept
+	{
+		const uint64_t offset = top & head_offset_mask;
+
+		return offset == 0 ? nullptr : reinterpret_cast<FreeBlock*>(m_base + ((offset - 1U) << quantum_shift));
+	}
+
+	[[nodiscard]] inline uint64_t encode(const FreeBlock* block, uint64_t top) const noexcept
+	{
+		const uint64_t offset = block == nullptr ? 0 :
+			(static_cast<uint64_t>(reinterpret_cast<const std::byte*>(block) - m_base) >> quantum_shift) + 1U;
+
+		return (((top >> head_tag_shift) + 1U) << head_tag_shift) | offset;
+	}
+
+	// counters are bumped where blocks leave or enter a freelist, so every path is counted exactly once
+
+	inline void count_taken(proxy_index_t proxy_index, size_t count) noexcept
+	{
+		auto& counters = m_counters[proxy_index];
+
+		if constexpr (Config::concurrent) {
+			const uint64_t in_use = counters.in_use.fetch_add(count, std::memory_order_relaxed) + count;
+
+			uint64_t high = counters.high_water.load(std::memory_order_relaxed);
+
+			while (in_use > high && !counters.high_water.compare_exchange_weak(high, in_use, std::memory_order_relaxed));
+		}
+		else {
+			counters.in_use += count;
+			counters.high_water = std::max(counters.high_water, counters.in_use);
+		}
+	}
+
+	inline void count_returned(proxy_index_t proxy_index, size_t count) noexcept
+	{
+		if constexpr (Config::concurrent)
+			m_counters[proxy_index].in_use.fetch_sub(count, std::memory_order_relaxed);
+		else
+			m_counters[proxy_index].in_use -= count;
+	}
+
+	inline void count_fallback(proxy_index_t proxy_index, size_t count) noexcept
+	{
+		if constexpr (Config::concurrent)
+			m_counters[proxy_index].fallbacks.fetch_add(count, std::memory_order_relaxed);
+		else
+			m_counters[proxy_index].fallbacks += count;
+	}
+
+	inline void count_exhaustion(proxy_index_t proxy_index) noexcept
+	{
+		if constexpr (Config::concurrent)
+			m_counters[proxy_index].exhaustions.fetch_add(1, std::memory_order_relaxed);
+		else
+			++m_counters[proxy_index].exhaustions;
+	}
+
+	[[nodiscard]] inline bool head_empty(proxy_index_t proxy_index) const noexcept
+	{
+		if constexpr (Config::concurrent)
+			return (m_heads[proxy_index].top.load(std::memory_order_acquire) & head_offset_mask) == 0;
+		else
+			return m_heads[proxy_index] == nullptr;
+	}
+
+	[[nodiscard]] inline std::byte* carve(proxy_index_t proxy_index) noexcept
+	{
+		std::byte* block = nullptr;
+
+		if constexpr (Config::concurrent)
+			block = m_proxies[proxy_index].carve_shared();
+		else
+			block = m_proxies[proxy_index].carve();
+
+		if (block != nullptr) [[likely]]
+			count_taken(proxy_index, 1);
+
+		return block;
+	}
+
+	[[nodiscard]] inline std::byte* pop(proxy_index_t proxy_index) noexcept
+	{
+		if constexpr (Config::concurrent) {
+			auto& top = m_heads[proxy_index].top;
+
+			uint64_t current = top.load(std::memory_order_acquire);
+
+			// a stale next read from a block that was popped meanwhile is discarded by the tag mismatch
+
+			for (;;) {
+				FreeBlock* head = decode(current);
+
+				if (head == nullptr) [[unlikely]]
+					return nullptr;
+
+				FreeBlock* next = std::atomic_ref<FreeBlock*>{head->next}.load(std::memory_order_relaxed);
+
+				if (top.compare_exchange_weak(current, encode(next, current),
+					std::memory_order_acquire, std::memory_order_acquire)) [[likely]] {
+					count_taken(proxy_index, 1);
+					return reinterpret_cast<std::byte*>(head);
+				}
+			}
+		}
+		else {
+			FreeBlock* head = m_heads[proxy_index];
+
+			if (head == nullptr) [[unlikely]]
+				return nullptr;
+
+			m_heads[proxy_index] = head->next;
+			count_taken(proxy_index, 1);
+			return reinterpret_cast<std::byte*>(head);
+		}
+	}
+
+	[[nodiscard]] inline std::byte* take(proxy_index_t proxy_index) noexcept
+	{
+		if (std::byte* block = pop(proxy_index))
+			return block;
+
+		return carve(proxy_index);
+	}
+
+	inline size_t pop_run(proxy_index_t proxy_index, size_t count, std::byte** out) noexcept
+	{
+		size_t taken = 0;
+
+		if constexpr (Config::concurrent) {
+			auto& top = m_heads[proxy_index].top;
+
+			uint64_t current = top.load(std::memory_order_acquire);
+
+			// detaches up to count blocks with one exchange; every link is read only while the head is
+			// unchanged, and every push or pop bumps the tag, so a matching head means the chain was intact
+
+			for (;;) {
+				FreeBlock* node = decode(current);
+
+				bool intact = true;
+				taken = 0;
+
+				while (taken < count && node != nullptr) {
+					out[taken++] = reinterpret_cast<std::byte*>(node);
+
+					node = std::atomic_ref<FreeBlock*>{node->next}.load(std::memory_order_acquire);
+
+					if (top.load(std::memory_order_acquire) != current) {
+						intact = false;
+						break;
+					}
+				}
+
+				if (!intact) {
+					current = top.load(std::memory_order_acquire);
+					continue;
+				}
+
+				if (taken == 0 || top.compare_exchange_strong(current, encode(node, current),
+					std::memory_order_acquire, std::memory_order_acquire)) [[likely]]
+					break;
+			}
+		}
+		else {
+			FreeBlock* head = m_heads[proxy_index];
+
+			while (taken < count && head != nullptr) {
+				out[taken++] = reinterpret_cast<std::byte*>(head);
+				head = head->next;
+			}
+
+			m_heads[proxy_index] = head;
+		}
+
+		if (taken != 0)
+			count_taken(proxy_index, taken);
+
+		return taken;
+	}
+
+	inline size_t take_run(proxy_index_t proxy_index, size_t count, std::byte** out) noexcept
+	{
+		size_t taken = pop_run(proxy_index, count, out);
+
+		while (taken < count) {
+			std::byte* block = carve(proxy_index);
+
+			if (block == nullptr)
+				break;
+
+			out[taken++] = block;
+		}
+
+		return taken;
+	}
+
+	inline void splice(proxy_index_t proxy_index, FreeBlock* first, FreeBlock* last, size_t count) noexcept
+	{
+		count_returned(proxy_index, count);
+
+		if constexpr (Config::concurrent) {
+			auto& top = m_heads[proxy_index].top;
+
+			uint64_t current = top.load(std::memory_order_relaxed);
+
+			do {
+				std::atomic_ref<FreeBlock*>{last->next}.store(decode(current), std::memory_order_relaxed);
+			} while (!top.compare_exchange_weak(current, encode(first, current),
+				std::memory_order_release, std::memory_order_relaxed));
+
+			if ((current & head_offset_mask) == 0)
+				mark_occupied(proxy_index);
+		}
+		else {
+			if (m_heads[proxy_index] == nullptr)
+				mark_occupied(proxy_index);
+
+			last->next = m_heads[proxy_index];
+			m_heads[proxy_index] = first;
+		}
+	}
+
+	[[nodiscard]] inline proxy_index_t proxy_of(const std::byte* block) const noexcept
+	{
+		if constexpr (Config::header_free) {
+			return m_pages.lookup(block);
+		}
+		else {
+			const std::byte* header = block - sizeof(proxy_index_t);
+
+			return static_cast<proxy_index_t>(header[0]) |
+				(static_cast<proxy_index_t>(header[1]) << 8);
+		}
+	}
+
+	// a TLS allocator owns its arena and overflow segments, anything outside them was handed over by another thread
+
+	[[nodiscard]] inline bool is_foreign(const std::byte* block) const noexcept
+	{
+		if constexpr (Config::concurrent)
+			return false;
+		else
+			return m_remote != nullptr && !m_remote->owns(block);
+	}
+
+	inline void free_remote(std::byte* block) noexcept
+	{
+		remote_queue_t* owner = remote_queue_t::owner_of(block);
+
+		MTP_ASSERT(owner != nullptr,
+			mtp::err::remote_owner_gone);
+
+		if (owner != nullptr) [[likely]]
+			owner->push(block);
+	}
+
+	// blocks other threads returned to this arena go back to their own freelists
+
+	inline bool drain_remote() noexcept
+	{
+		if (m_remote == nullptr)
+			return false;
+
+		FreeBlock* node = m_remote->take();
+
+		if (node == nullptr) [[likely]]
+			return false;
+
+		while (node != nullptr) {
+			FreeBlock* next = node->next;
+			auto* block = reinterpret_cast<std::byte*>(node);
+
+			push(proxy_of(block), block);
+
+			node = next;
+		}
+
+		return true;
+	}
+
+	inline void push(proxy_index_t proxy_index, std::byte* block) noexcept
+	{
+		MTP_ASSERT(Config::elastic || m_proxies[proxy_index].owns(block),
+			mtp::err::release_block_outside);
+
+		auto* head = reinterpret_cast<FreeBlock*>(block);
+
+		if constexpr (Config::concurrent) {
+			splice(proxy_index, head, head, 1);
+		}
+		else {
+			count_returned(proxy_index, 1);
+
+			if (m_heads[proxy_index] == nullptr) [[unlikely]]
+				mark_occupied(proxy_index);
+
+			head->next = m_heads[proxy_index];
+			m_heads[proxy_index] = head;
+		}
+	}
+
 	static inline constexpr proxy_index_t lookup(uint32_t raw_size, uint32_t alignment)
+	{
+		const proxy_index_t proxy_index = resolve(raw_size, alignment);
+
+		if (proxy_index != mtp::cfg::SizeClassConstraints::invalid_proxy)
+			mtp::cfg::AllocTracer::trace(raw_size, alignment, Config::proxy_strides[proxy_index], proxy_index);
+
+		return proxy_index;
+	}
+
+	static inline constexpr proxy_index_t resolve(uint32_t raw_size, uint32_t alignment)
 	{
 		MTP_ASSERT(raw_size > 0,
 			mtp::err::lookup_raw_size_zero);
 
-		constexpr auto& metadata = Config::range_metadata;
-		constexpr uint32_t range_count = Config::range_count;
+		const proxy_index_t proxy_index = resolve_unchecked(raw_size, alignment);
 
-		const uint32_t alloc_size = raw_size + sizeof(proxy_index_t);
+		MTP_ASSERT_CTX(proxy_index != mtp::cfg::SizeClassConstraints::invalid_proxy,
+			mtp::err::lookup_no_match,
+			mtp::err::format_ctx("size = %u, align = %u", raw_size, alignment));
+
+		return proxy_index;
+	}
+
+	static inline constexpr proxy_index_t resolve_unchecked(uint32_t raw_size, uint32_t alignment) noexcept
+	{
+		constexpr auto& table = Config::size_class_table;
+
+		// nothing above the largest stride can match, rejecting it first keeps the header and rounding from wrapping
+
+		if (raw_size > mtp::cfg::MetapoolConstraints::max_stride || alignment > mtp::cfg::MetapoolConstraints::max_stride) [[unlikely]]
+			return mtp::cfg::SizeClassConstraints::invalid_proxy;
+
+		const uint32_t alloc_size = raw_size + Config::block_header_bytes;
 		const uint32_t align_to   = std::max(Config::alignment_quantum, alignment);
 		const uint32_t aligned    = (alloc_size + align_to - 1U) & ~(align_to - 1U);
 
-		for (uint32_t mp_index = 0; mp_index < range_count; ++mp_index) {
+		return aligned <= mtp::cfg::SizeClassConstraints::small_limit
+			? table.small_proxy[aligned >> mtp::cfg::SizeClassConstraints::quantum_shift]
+			: lookup_large(aligned);
+	}
 
-			const auto& range     = metadata[mp_index];
-			const uint32_t mask   = range.stride_step - 1U;
-			const uint32_t stride = (aligned + mask) & ~mask;
+	static inline constexpr proxy_index_t lookup_large(uint32_t aligned)
+	{
+		constexpr auto& metadata = Config::range_metadata;
+		constexpr auto& table    = Config::size_class_table;
 
-			if (stride > range.stride_max)
-				continue;
+		constexpr uint32_t range_count = Config::range_count;
+		constexpr uint32_t sub_mask    = (1U << table.sub_bits) - 1U;
 
-			const uint32_t offset = (stride - range.stride_min) &
-				-static_cast<int32_t>(stride >= range.stride_min);
+		const uint32_t value  = aligned - 1U;
+		const uint32_t log2   = static_cast<uint32_t>(std::bit_width(value)) - 1U;
+		const uint32_t bucket =
+			((log2 - mtp::cfg::SizeClassConstraints::small_shift) << table.sub_bits) |
+			((value >> (log2 - table.sub_bits)) & sub_mask);
 
-			const uint32_t fl_index = offset >> range.stride_shift;
+		uint32_t mp_index = table.large_range[bucket];
 
-			MTP_ASSERT((offset & mask) == 0,
-				mtp::err::lookup_stride_misaligned);
+		const auto stride_of = [aligned](const auto& range) {
+			const uint32_t mask = range.stride_step - 1U;
+			return (aligned + mask) & ~mask;
+		};
 
-			proxy_index_t proxy_index = range.base_proxy_index + fl_index;
+		if constexpr (table.large_exact) {
+			if (mp_index < range_count && stride_of(metadata[mp_index]) > metadata[mp_index].stride_max)
+				++mp_index;
+		}
+		else {
+			while (mp_index < range_count && stride_of(metadata[mp_index]) > metadata[mp_index].stride_max)
+				++mp_index;
+		}
 
-			mtp::cfg::AllocTracer::trace(raw_size, alignment, stride, proxy_index);
+		if (mp_index >= range_count) [[unlikely]]
+			return mtp::cfg::SizeClassConstraints::invalid_proxy;
 
-			return proxy_index;
-		}
+		const auto& range     = metadata[mp_index];
+		const uint32_t stride = stride_of(range);
 
-		MTP_ASSERT_CTX(false,
-			mtp::err::lookup_no_match,
-			mtp::err::format_ctx("size = %u, align = %u", raw_size, alignment));
+		const uint32_t offset = (stride - range.stride_min) &
+			-static_cast<int32_t>(stride >= range.stride_min);
+
+		MTP_ASSERT((offset & (range.stride_step - 1U)) == 0,
+			mtp::err::lookup_stride_misaligned);
 
-		return 0xFFFF;
+		return static_cast<proxy_index_t>(range.base_proxy_index + (offset >> range.stride_shift));
 	}
 
 private:
 
+	std::span<head_t>        m_heads;
+	std::span<counters_t>    m_counters;
+	std::span<uint64_t>      m_occupancy;
 	std::span<FreelistProxy> m_proxies;
+
+	PageMap m_pages;
+
+	OverflowArena* m_overflow {nullptr};
+
+	std::byte* m_base {nullptr};
+
+	remote_queue_t* m_remote {nullptr};
+
+
+	template <typename Set>
+	friend class MagazineCache;
 };
 
 
@@ -3,9 +3,11 @@
 #include "mtpint.hpp"
 
 #include <array>
+#include <algorithm>
 #include <type_traits>
 
 #include "fail.hpp"
+#include "set_options.hpp"
 #include "freelist_proxy.hpp"
 
 
@@ -15,14 +17,42 @@ namespace mtp::cfg {
 struct allocator_config_tag {};
 
 
-template <auto MetapoolRangeArray>
+template <auto MetapoolRangeArray, auto SizeClassTable, auto ProxyBlockCounts, auto MetapoolOrder, SetOptions Options = SetOptions{}>
 struct AllocatorConfig
 {
 	using tag = allocator_config_tag;
 
+	static constexpr SetOptions options = Options;
+
+	static constexpr bool header_free = Options.block_header == BlockHeader::page_map;
+
+	static constexpr uint32_t block_header_bytes = header_free ? 0U : static_cast<uint32_t>(sizeof(uint16_t));
+
+	static constexpr bool elastic = Options.elastic;
+
+	static_assert(!(elastic && header_free),
+		CONFIG_ELASTIC_HEADER_FREE_MSG);
+
+	static constexpr bool packed = Options.pack_stride_limit != 0;
+
+	static_assert(!(packed && header_free),
+		CONFIG_PACK_HEADER_FREE_MSG);
+
+	static constexpr bool concurrent = false;
+
 	static constexpr auto range_metadata = MetapoolRangeArray;
 	static constexpr uint32_t range_count = static_cast<uint32_t>(range_metadata.size());
 
+	static constexpr auto size_class_table   = SizeClassTable;
+	static constexpr auto proxy_block_counts = ProxyBlockCounts;
+
+	// range_metadata is sorted by stride, metapool_order maps a metapool's declaration index to its range
+
+	static constexpr auto metapool_order = MetapoolOrder;
+
+	static_assert(metapool_order.size() == range_count,
+		CONFIG_METAPOOL_ORDER_SIZE_MSG);
+
 	static constexpr size_t total_stride_count = [] {
 		uint32_t total = 0;
 		for (uint32_t i = 0; i < range_count; ++i)
@@ -35,8 +65,29 @@ struct AllocatorConfig
 	static_assert(total_stride_count <= max_stride_count,
 		CONFIG_STRIDE_LIMIT_MSG);
 
+	static_assert(proxy_block_counts.size() == total_stride_count,
+		CONFIG_BLOCK_COUNT_SIZE_MSG);
+
 	using ProxyArrayType = std::array<mtp::core::FreelistProxy, total_stride_count>;
 
+	static constexpr auto proxy_strides = [] {
+		std::array<uint32_t, total_stride_count> strides {};
+		for (uint32_t i = 0; i < range_count; ++i)
+			for (uint32_t j = 0; j < range_metadata[i].stride_count; ++j)
+				strides[range_metadata[i].base_proxy_index + j] =
+					range_metadata[i].stride_min + j * range_metadata[i].stride_step;
+		return strides;
+	}();
+
+	static constexpr auto elastic_chunk_blocks = [] {
+		std::array<uint32_t, total_stride_count> chunk_blocks {};
+		for (size_t i = 0; i < total_stride_count; ++i) {
+			const uint32_t fit = Options.elastic_chunk_bytes / proxy_strides[i];
+			chunk_blocks[i] = std::max(1U, std::min(fit, proxy_block_counts[i]));
+		}
+		return chunk_blocks;
+	}();
+
 	static constexpr uint32_t alignment_quantum {8U};
 
 	static constexpr uint32_t min_stride = range_metadata[0].stride_min;
@@ -50,6 +101,18 @@ struct AllocatorConfig
 };
 
 
+// same layout as the base config, served through lock-free heads by concurrent shared instances
+
+template <typename Base>
+struct ConcurrentConfig : std::remove_cvref_t<Base>
+{
+	static constexpr bool concurrent = true;
+
+	static_assert(!std::remove_cvref_t<Base>::elastic,
+		CONFIG_CONCURRENT_ELASTIC_MSG);
+};
+
+
 template <typename Config>
 concept IsAllocatorConfig = requires {
 
@@ -57,6 +120,8 @@ concept IsAllocatorConfig = requires {
 	typename std::remove_cvref_t<Config>::ProxyArrayType;
 
 	{ std::remove_cvref_t<Config>::range_metadata };
+	{ std::remove_cvref_t<Config>::size_class_table };
+	{ std::remove_cvref_t<Config>::proxy_block_counts };
 	{ std::remove_cvref_t<Config>::range_count }        -> std::convertible_to<uint32_t>;
 	{ std::remove_cvref_t<Config>::total_stride_count } -> std::convertible_to<size_t>;
 	{ std::remove_cvref_t<Config>::alignment_quantum }  -> std::convertible_to<uint32_t>;
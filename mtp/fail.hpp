@@ -308,28 +308,40 @@ inline constexpr msg destruct_proxy_oob
 	"[allocator::destruct] proxy index out of bounds"
 };
 
-inline constexpr msg init_memory_null
+inline constexpr msg core_overflow_null
 {
 	ascii_sea,
-	"[freelist::initialize] passed memory is nullptr"
+	"[allocator::allocator] elastic set without overflow arena"
 };
 
-inline constexpr msg init_base_misaligned
+inline constexpr msg alloc_batch_out_null
 {
-	ascii_land,
-	"[freelist::initialize] base misaligned"
+	ascii_city,
+	"[allocator::alloc_batch] output array is nullptr"
 };
 
-inline constexpr msg init_next_misaligned
+inline constexpr msg free_batch_blocks_null
 {
 	ascii_city,
-	"[freelist::initialize] next block misaligned"
+	"[allocator::free_batch] block array is nullptr"
 };
 
-inline constexpr msg release_block_null
+inline constexpr msg init_memory_null
 {
-	ascii_city,
-	"[freelist::release] block is nullptr"
+	ascii_sea,
+	"[freelist::initialize] passed memory is nullptr"
+};
+
+inline constexpr msg init_prefix_overflow
+{
+	ascii_sea,
+	"[freelist::initialize] packed prefix exceeds the block count"
+};
+
+inline constexpr msg init_base_misaligned
+{
+	ascii_land,
+	"[freelist::initialize] base misaligned"
 };
 
 inline constexpr msg release_block_outside
@@ -356,10 +368,34 @@ inline constexpr msg metapool_upstream_null
 	"[metapool::metapool] upstream is nullptr"
 };
 
-inline constexpr msg metapool_freelist_null
+inline constexpr msg core_base_null
+{
+	ascii_city,
+	"[allocator::allocator] concurrent allocator requires the arena base"
+};
+
+inline constexpr msg remote_owners_full
+{
+	ascii_land,
+	"[owner_registry::insert] too many live TLS arena ranges"
+};
+
+inline constexpr msg remote_owner_gone
+{
+	ascii_sea,
+	"[allocator::free] foreign block has no live owning arena"
+};
+
+inline constexpr msg page_map_entries_null
 {
 	ascii_sea,
-	"[metapool::freelist_interface] freelist_ptr is nullptr"
+	"[page_map::page_map] entry table is nullptr"
+};
+
+inline constexpr msg page_map_range_oob
+{
+	ascii_sea,
+	"[page_map] pointer outside of mapped arena pages"
 };
 
 inline constexpr msg metapool_fetch_block_null
@@ -383,7 +419,7 @@ inline constexpr msg metapool_release_index_oob
 inline constexpr msg arena_alloc_failed
 {
 	ascii_land,
-	"[arena::arena] aligned_alloc failed"
+	"[arena::arena] mmap failed"
 };
 
 inline constexpr msg arena_fetch_no_fit
@@ -392,12 +428,42 @@ inline constexpr msg arena_fetch_no_fit
 	"[arena::fetch] not enough space to fit aligned allocation"
 };
 
+inline constexpr msg arena_base_misaligned
+{
+	ascii_city,
+	"[arena::arena] mapping is not aligned to the requested arena alignment"
+};
+
 inline constexpr msg arena_fetch_overflow
 {
 	ascii_city,
 	"[arena::fetch] allocation exceeds available capacity"
 };
 
+inline constexpr msg frame_exhausted
+{
+	ascii_sea,
+	"[frame_arena::alloc] frame capacity exhausted"
+};
+
+inline constexpr msg frame_zero_size
+{
+	ascii_land,
+	"[frame_arena::alloc] size must be > 0"
+};
+
+inline constexpr msg frame_alignment_pow2
+{
+	ascii_city,
+	"[frame_arena::alloc] alignment is not a power of two"
+};
+
+inline constexpr msg frame_rewind_foreign
+{
+	ascii_land,
+	"[frame_arena::rewind] marker outside the current frame"
+};
+
 
 inline constexpr const char* vault_index_oob =
 	"[vault] index out of bounds";
@@ -420,6 +486,9 @@ inline constexpr const char* vault_move_null_data =
 inline constexpr const char* vault_clear_null_data =
 	"[vault::clear] non-zero size with null data";
 
+inline constexpr const char* vault_size_overflow =
+	"[vault] element count exceeds the allocator size limit";
+
 
 inline constexpr const char* slag_index_oob =
 	"[slag] index out of bounds";
@@ -448,6 +517,9 @@ inline constexpr const char* slag_move_null_data =
 inline constexpr const char* slag_clear_null_data =
 	"[slag::clear] non-zero size with null data";
 
+inline constexpr const char* slag_size_overflow =
+	"[slag] element count exceeds the allocator size limit";
+
 
 inline constexpr const char* chaselev_reserve_non_empty =
 	"[chaselev::reserve] forbidden if running";
@@ -518,6 +590,22 @@ inline constexpr const char* chaselev_reserve_non_empty =
 
 )"
 
+#define CORE_METAPOOL_INDEX_MSG R"(
+
+************************************************************
+* [allocator core] metapool index exceeds the metaset size *
+************************************************************
+
+)"
+
+#define CORE_CONSTRUCT_NO_MATCH_MSG R"(
+
+********************************************************
+* [allocator core] no metapool fits sizeof / alignof T *
+********************************************************
+
+)"
+
 #define CONFIG_STRIDE_LIMIT_MSG R"(
 
 *******************************************************************
@@ -527,6 +615,46 @@ inline constexpr const char* chaselev_reserve_non_empty =
 
 )"
 
+#define CONFIG_BLOCK_COUNT_SIZE_MSG R"(
+
+***************************************************************
+* [allocator config] block count table does not match strides *
+***************************************************************
+
+)"
+
+#define CONFIG_METAPOOL_ORDER_SIZE_MSG R"(
+
+***************************************************************
+* [allocator config] metapool order does not match range list *
+***************************************************************
+
+)"
+
+#define CONFIG_ELASTIC_HEADER_FREE_MSG R"(
+
+****************************************************************
+* [allocator config] elastic sets require inline block headers *
+****************************************************************
+
+)"
+
+#define CONFIG_PACK_HEADER_FREE_MSG R"(
+
+***************************************************************
+* [allocator config] packed sets require inline block headers *
+***************************************************************
+
+)"
+
+#define CONFIG_CONCURRENT_ELASTIC_MSG R"(
+
+*****************************************************************************
+* [allocator config] lock-free shared instances do not support elastic sets *
+*****************************************************************************
+
+)"
+
 #define CONFIG_EMPTY_RANGE_MSG R"(
 
 ***************************************************
@@ -585,4 +713,20 @@ inline constexpr const char* chaselev_reserve_non_empty =
 
 )"
 
+#define TYPESET_EMPTY_MSG R"(
+
+*********************************************
+* [metaset_for] type list must not be empty *
+*********************************************
+
+)"
+
+#define TYPESET_TYPE_TOO_LARGE_MSG R"(
+
+***********************************************************
+* [metaset_for] sizeof(T) + header exceeds the max stride *
+***********************************************************
+
+)"
+
 } // mtp::err
@@ -0,0 +1,362 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <new>
+#include <array>
+#include <limits>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include <memory_resource>
+
+#include "set_options.hpp"
+#include "memory_model.hpp"
+#include "monotonic_arena.hpp"
+
+#include "fail.hpp"
+
+
+namespace mtp::cfg {
+
+
+enum class FrameBuffering
+{
+	single,          // one bump range, flip() rewinds it
+	double_buffered  // two ranges, flip() switches to the other one so the previous frame stays readable for a frame
+};
+
+
+struct FrameOptions
+{
+	// bytes per frame, a double-buffered arena reserves twice as much; rounded up to whole pages
+
+	size_t capacity {64ULL << 20};
+
+	FrameBuffering buffering {FrameBuffering::single};
+
+	CommitPolicy commit           {CommitPolicy::reserve};
+	uint32_t     prefault_threads {0};
+
+	HugePages huge_pages {HugePages::none};
+};
+
+} // mtp::cfg
+
+
+namespace mtp::core {
+
+
+struct FrameMarker
+{
+	size_t offset {0};
+};
+
+
+template <typename T, typename Frame>
+class FrameAdapter;
+
+
+// bump allocator over a MonotonicArena mapping: blocks are never freed one by one, a frame is dropped
+// with flip() / reset() and a nested scope with rewind() to a marker taken by mark()
+// the lock-free policy makes alloc safe across threads; mark, rewind and flip are never concurrent with it
+
+template <mtp::cfg::FrameOptions Options, mtp::cfg::SharedPolicy Policy = mtp::cfg::SharedPolicy::exclusive>
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+
+	static constexpr bool   double_buffered = Options.buffering == mtp::cfg::FrameBuffering::double_buffered;
+	static constexpr bool   concurrent      = Policy == mtp::cfg::SharedPolicy::lock_free;
+	static constexpr size_t page_size       = mtp::cfg::arena_alignment;
+
+	static constexpr size_t frame_bytes = (Options.capacity + page_size - 1) / page_size * page_size;
+	static constexpr size_t frame_count = double_buffered ? 2U : 1U;
+
+	explicit FrameArena(
+		mtp::cfg::CommitPolicy commit           = Options.commit,
+		uint32_t               prefault_threads = Options.prefault_threads
+	)
+		: m_arena {frame_bytes * frame_count, page_size, commit, prefault_threads, Options.huge_pages}
+	{}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	FrameArena(FrameArena&&) = delete;
+	FrameArena& operator=(FrameArena&&) = delete;
+
+public:
+
+	[[nodiscard]] inline std::byte* alloc(size_t size, size_t alignment)
+	{
+		std::byte* block = try_alloc(size, alignment);
+
+		if (block == nullptr) [[unlikely]] {
+			mtp::err::fatal(mtp::err::frame_exhausted,
+				mtp::err::format_ctx("size = %zu, align = %zu, used = %zu / %zu",
+					size, alignment, used(), frame_bytes));
+		}
+
+		return block;
+	}
+
+	[[nodiscard]] inline std::byte* try_alloc(size_t size, size_t alignment) noexcept
+	{
+		MTP_ASSERT(size > 0,
+			mtp::err::frame_zero_size);
+
+		MTP_ASSERT((alignment & (alignment - 1)) == 0,
+			mtp::err::frame_alignment_pow2);
+
+		if constexpr (concurrent) {
+			size_t current = m_offset.load(std::memory_order_relaxed);
+			size_t begin   = 0;
+
+			do {
+				begin = align_offset(current, alignment);
+
+				if (begin + size > m_frame_end) [[unlikely]]
+					return nullptr;
+			}
+			while (!m_offset.compare_exchange_weak(current, begin + size,
+				std::memory_order_relaxed, std::memory_order_relaxed));
+
+			return m_arena.base() + begin;
+		}
+		else {
+			const size_t begin = align_offset(m_offset, alignment);
+
+			if (begin + size > m_frame_end) [[unlikely]]
+				return nullptr;
+
+			m_offset = begin + size;
+
+			return m_arena.base() + begin;
+		}
+	}
+
+	template <typename T, typename... Args>
+	[[nodiscard]] inline T* construct(Args&&... args)
+	{
+		return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// blocks handed out after the marker are dropped, their destructors are not run
+
+	[[nodiscard]] inline FrameMarker mark() const noexcept
+	{
+		return FrameMarker {offset()};
+	}
+
+	inline void rewind(FrameMarker marker) noexcept
+	{
+		MTP_ASSERT(marker.offset >= m_frame_end - frame_bytes && marker.offset <= offset(),
+			mtp::err::frame_rewind_foreign);
+
+		store_offset(marker.offset);
+	}
+
+	class Scope final
+	{
+	public:
+
+		explicit Scope(FrameArena& frame) noexcept
+			: m_frame  {&frame}
+			, m_marker {frame.mark()}
+		{}
+
+		~Scope()
+		{
+			m_frame->rewind(m_marker);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		Scope(Scope&&) = delete;
+		Scope& operator=(Scope&&) = delete;
+
+	private:
+
+		FrameArena* m_frame;
+		FrameMarker m_marker;
+	};
+
+	[[nodiscard]] inline Scope scope() noexcept
+	{
+		return Scope {*this};
+	}
+
+	// starts the next frame: a single arena rewinds, a double-buffered one switches halves and rewinds
+	// the new half, so blocks of the frame before stay valid until the following flip
+
+	inline void flip() noexcept
+	{
+		if constexpr (double_buffered)
+			m_current ^= 1U;
+
+		reset();
+	}
+
+	inline void reset() noexcept
+	{
+		m_frame_end = frame_bytes * (m_current + 1U);
+
+		store_offset(m_frame_end - frame_bytes);
+	}
+
+	[[nodiscard]] inline size_t used() const noexcept
+	{
+		return offset() - (m_frame_end - frame_bytes);
+	}
+
+	[[nodiscard]] static constexpr size_t capacity() noexcept
+	{
+		return frame_bytes;
+	}
+
+	template <typename T>
+	using std_adapter_t = FrameAdapter<T, FrameArena>;
+
+	template <typename T>
+	[[nodiscard]] inline std_adapter_t<T> get_std_adapter() noexcept
+	{
+		return std_adapter_t<T> {*this};
+	}
+
+	template <typename T>
+	[[nodiscard]] inline std::pmr::polymorphic_allocator<T> get_pmr_adapter() noexcept
+	{
+		return std::pmr::polymorphic_allocator<T> {static_cast<std::pmr::memory_resource*>(this)};
+	}
+
+protected:
+
+	// a pmr request for 0 bytes is legal and gets a distinct 1-byte block
+
+	void* do_allocate(size_t count, size_t alignment) override
+	{
+		return alloc(count == 0 ? 1U : count, alignment);
+	}
+
+	void do_deallocate(void*, size_t, size_t) override
+	{}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+
+	// aligns the absolute address, so alignments above the page size hold as well
+
+	[[nodiscard]] inline size_t align_offset(size_t offset, size_t alignment) const noexcept
+	{
+		const auto address = reinterpret_cast<std::uintptr_t>(m_arena.base()) + offset;
+
+		return offset + (((address + alignment - 1) & ~(alignment - 1)) - address);
+	}
+
+	[[nodiscard]] inline size_t offset() const noexcept
+	{
+		if constexpr (concurrent)
+			return m_offset.load(std::memory_order_relaxed);
+		else
+			return m_offset;
+	}
+
+	inline void store_offset(size_t offset) noexcept
+	{
+		if constexpr (concurrent)
+			m_offset.store(offset, std::memory_order_relaxed);
+		else
+			m_offset = offset;
+	}
+
+	using offset_t = std::conditional_t<concurrent, std::atomic<size_t>, size_t>;
+
+	MonotonicArena m_arena;
+
+	alignas(std::hardware_destructive_interference_size) offset_t m_offset {0};
+
+	size_t   m_frame_end {frame_bytes};
+	uint32_t m_current   {0};
+};
+
+
+// std allocator over a frame: deallocate is a no-op, memory returns when the frame is rewound or flipped
+
+template <typename T, typename Frame>
+class FrameAdapter
+{
+public:
+
+	using value_type = T;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+
+	using is_always_equal = std::false_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	explicit FrameAdapter(Frame& frame) noexcept
+		: m_frame {&frame}
+	{}
+
+	template <typename Rebound>
+	FrameAdapter(const FrameAdapter<Rebound, Frame>& other) noexcept
+		: m_frame {other.frame()}
+	{}
+
+	template <typename Rebound>
+	bool operator==(const FrameAdapter<Rebound, Frame>& other) const noexcept
+	{
+		return m_frame == other.frame();
+	}
+
+	template <typename Rebound>
+	bool operator!=(const FrameAdapter<Rebound, Frame>& other) const noexcept
+	{
+		return m_frame != other.frame();
+	}
+
+	template <typename Rebound>
+	struct rebind
+	{
+		using other = FrameAdapter<Rebound, Frame>;
+	};
+
+	template <typename ObjType>
+	using rebind_t = FrameAdapter<ObjType, Frame>;
+
+	T* allocate(size_type count)
+	{
+		if (count > max_size()) [[unlikely]]
+			throw std::bad_array_new_length {};
+
+		return reinterpret_cast<T*>(m_frame->alloc(count == 0 ? sizeof(T) : count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_type) noexcept
+	{}
+
+	[[nodiscard]] static constexpr size_type max_size() noexcept
+	{
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	[[nodiscard]] Frame* frame() const noexcept
+	{
+		return m_frame;
+	}
+
+private:
+
+	Frame* m_frame;
+};
+
+} // mtp::core
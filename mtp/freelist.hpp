@@ -2,6 +2,8 @@
 
 #include "mtpint.hpp"
 
+#include <new>
+#include <atomic>
 #include <cassert>
 
 #include "fail.hpp"
@@ -10,131 +12,208 @@
 namespace mtp::core {
 
 
-template <uint32_t Stride, uint32_t BlockCount>
-class Freelist final
+struct FreeBlock
 {
-	static_assert(Stride >= sizeof(void*),
-		FREELIST_STRIDE_TOO_SMALL_MSG);
+	FreeBlock* next;
+};
 
-public:
 
-	Freelist() = default;
-	~Freelist() = default;
+// lock-free stack head for concurrent allocators: a 32-bit generation tag over a 32-bit block offset
+// from the arena base in alignment quanta, so a recycled block never compares equal to a stale head
 
-	Freelist(const Freelist&) = default;
-	Freelist& operator=(const Freelist&) = default;
-	Freelist(Freelist&&) = default;
-	Freelist& operator=(Freelist&&) = default;
+struct alignas(std::hardware_destructive_interference_size) SharedHead
+{
+	std::atomic<uint64_t> top {0};
+};
 
-	using proxy_index_t = uint16_t;
 
+// hybrid freelist: recycled blocks live on an intrusive list whose head is owned by the allocator,
+// never-used blocks are carved from a bump cursor and get their header on first hand-out;
+// a packed freelist carves its prefix range first and spills into the primary range after it
 
-	void initialize(std::byte* memory, proxy_index_t proxy_index)
-	{
-		MTP_ASSERT(memory != nullptr,
-			mtp::err::init_memory_null);
+class FreelistBase
+{
+public:
 
-		MTP_ASSERT(reinterpret_cast<std::uintptr_t>(memory) % alignof(Block) == 0,
-			mtp::err::init_base_misaligned);
+	using proxy_index_t = uint16_t;
+
+	[[nodiscard]] inline std::byte* carve() noexcept
+	{
+		if (m_cursor == m_limit) [[unlikely]] {
+			if (!m_spill || m_memory_base == m_memory_end)
+				return nullptr;
 
-		const size_t total_bytes = static_cast<size_t>(BlockCount) * Stride;
+			m_spill  = false;
+			m_cursor = m_memory_base;
+			m_limit  = m_memory_end;
+		}
 
-		m_memory_base = memory;
-		m_memory_end  = memory + total_bytes;
+		std::byte* block = m_cursor;
+		m_cursor += m_stride;
 
-		m_head = reinterpret_cast<Block*>(memory);
-		Block* current = m_head;
+		stamp_header(block);
 
-		for (size_t i = 0; i < static_cast<size_t>(BlockCount); ++i) {
-			std::byte* block_ptr = memory + i * Stride;
-			Block* block = reinterpret_cast<Block*>(block_ptr);
+		return block;
+	}
 
-			std::byte* header_ptr = block->get_memory() - sizeof(proxy_index_t);
+	// concurrent carve: blocks are claimed by index, so racing threads never hand out the same block
 
-			header_ptr[0] = static_cast<std::byte>(proxy_index & 0xFF);
-			header_ptr[1] = static_cast<std::byte>((proxy_index >> 8) & 0xFF);
+	[[nodiscard]] inline std::byte* carve_shared() noexcept
+	{
+		const uint64_t index = std::atomic_ref<uint64_t>{m_carved}.fetch_add(1, std::memory_order_relaxed);
 
-			if (i + 1 < BlockCount) {
+		if (index >= m_block_count) [[unlikely]]
+			return nullptr;
 
-				Block* next = reinterpret_cast<Block*>(memory + (i + 1) * Stride);
+		std::byte* block = index < m_prefix_blocks
+			? m_prefix_base + index * m_stride
+			: m_memory_base + (index - m_prefix_blocks) * m_stride;
 
-				MTP_ASSERT(reinterpret_cast<std::uintptr_t>(next) % alignof(Block) == 0,
-					mtp::err::init_next_misaligned);
+		stamp_header(block);
 
-				block->next = next;
-			}
-			else {
-				block->next = nullptr;
-			}
-		}
+		return block;
 	}
 
+	// points the bump cursor at an overflow chunk; the packed and primary ranges are restored on reset
 
-	[[nodiscard]] inline std::byte* fetch() noexcept
+	inline void extend(std::byte* memory, size_t bytes) noexcept
 	{
-		if (m_head == nullptr) [[unlikely]]
-			return nullptr;
+		MTP_ASSERT(memory != nullptr,
+			mtp::err::init_memory_null);
 
-		Block* block = m_head;
-		m_head = m_head->next;
-		return block->get_memory();
+		m_cursor = memory;
+		m_limit  = memory + bytes;
 	}
 
-	inline void release(std::byte* block) noexcept
+	inline void reset() noexcept
 	{
-		MTP_ASSERT(block != nullptr,
-			 mtp::err::release_block_null);
-		MTP_ASSERT(block >= m_memory_base && block < m_memory_end,
-			mtp::err::release_block_outside);
-
-		auto* b = reinterpret_cast<Block*>(block);
-		b->next = m_head;
-		m_head = b;
+		rewind();
 	}
 
-	inline void reset() noexcept
+	[[nodiscard]] inline bool owns(const std::byte* block) const noexcept
 	{
-		m_head = reinterpret_cast<Block*>(m_memory_base);
-		Block* current = m_head;
+		return (block >= m_memory_base && block < m_memory_end) ||
+			(block >= m_prefix_base && block < m_prefix_end);
+	}
+
+	[[nodiscard]] inline bool can_carve() const noexcept
+	{ return m_cursor != m_limit || (m_spill && m_memory_base != m_memory_end); }
+
+	[[nodiscard]] inline bool can_carve_shared() noexcept
+	{ return std::atomic_ref<uint64_t>{m_carved}.load(std::memory_order_relaxed) < m_block_count; }
+
+protected:
+
+	inline void stamp_header(std::byte* block) const noexcept
+	{
+		if (m_write_header) {
+			std::byte* header_ptr = block - sizeof(proxy_index_t);
+
+			header_ptr[0] = static_cast<std::byte>(m_proxy_index & 0xFF);
+			header_ptr[1] = static_cast<std::byte>((m_proxy_index >> 8) & 0xFF);
+		}
+	}
 
-		std::byte* ptr = m_memory_base + Stride;
-		for (size_t i = 1; i < static_cast<size_t>(BlockCount); ++i, ptr += Stride) {
-			current->next = reinterpret_cast<Block*>(ptr);
-			current = current->next;
+	inline void rewind() noexcept
+	{
+		if (m_prefix_base != m_prefix_end) {
+			m_cursor = m_prefix_base;
+			m_limit  = m_prefix_end;
+			m_spill  = true;
+		}
+		else {
+			m_cursor = m_memory_base;
+			m_limit  = m_memory_end;
+			m_spill  = false;
 		}
 
-		current->next = nullptr;
+		m_carved = 0;
 	}
 
-	[[nodiscard]] bool empty() const noexcept
-	{ return m_head == nullptr; }
+	std::byte* m_memory_base {nullptr};
+	std::byte* m_memory_end  {nullptr};
+
+	std::byte* m_prefix_base {nullptr};
+	std::byte* m_prefix_end  {nullptr};
+
+	std::byte* m_cursor {nullptr};
+	std::byte* m_limit  {nullptr};
+
+	uint64_t m_carved {0};
+
+	uint32_t      m_stride        {0};
+	uint32_t      m_block_count   {0};
+	uint32_t      m_prefix_blocks {0};
+	proxy_index_t m_proxy_index  {0};
+	bool          m_write_header {true};
+	bool          m_spill        {false};
+};
+
+
+// stride and block count are runtime members, so every metapool shares one freelist type
+// and the init / reset code is instantiated once no matter how many strides a metaset has
+
+class Freelist final : public FreelistBase
+{
+public:
+
+	Freelist() = default;
+	~Freelist() = default;
 
-	[[nodiscard]] constexpr uint32_t stride() const noexcept
-	{ return Stride; }
+	Freelist(const Freelist&) = default;
+	Freelist& operator=(const Freelist&) = default;
+	Freelist(Freelist&&) = default;
+	Freelist& operator=(Freelist&&) = default;
 
-	[[nodiscard]] constexpr uint32_t block_count() const noexcept
-	{ return BlockCount; }
 
-private:
+	// the first prefix_blocks blocks live in the packed prefix, the rest in the primary range at memory
 
-	struct Block
+	void initialize(
+		std::byte*    memory,
+		uint32_t      stride,
+		uint32_t      block_count,
+		proxy_index_t proxy_index,
+		bool          write_header  = true,
+		std::byte*    prefix        = nullptr,
+		uint32_t      prefix_blocks = 0
+	)
 	{
-		union {
-			Block* next;
-			std::byte data[Stride];
-		};
+		MTP_ASSERT(prefix_blocks <= block_count,
+			mtp::err::init_prefix_overflow);
+
+		MTP_ASSERT(memory != nullptr || prefix_blocks == block_count,
+			mtp::err::init_memory_null);
 
-		inline std::byte* get_memory() noexcept { return data; }
-		inline const std::byte* get_memory() const noexcept { return data; }
-	};
+		MTP_ASSERT(reinterpret_cast<std::uintptr_t>(memory) % alignof(FreeBlock) == 0,
+			mtp::err::init_base_misaligned);
 
-	static_assert(sizeof(Block) <= Stride,
-		FREELIST_BLOCK_TOO_LARGE_MSG);
+		const size_t primary_bytes = static_cast<size_t>(block_count - prefix_blocks) * stride;
 
-	Block* m_head {nullptr};
+		m_memory_base = memory;
+		m_memory_end  = memory + primary_bytes;
 
-	std::byte* m_memory_base {nullptr};
-	std::byte* m_memory_end  {nullptr};
+		if (prefix_blocks != 0) {
+			MTP_ASSERT(prefix != nullptr,
+				mtp::err::init_memory_null);
+
+			m_prefix_base = prefix;
+			m_prefix_end  = prefix + static_cast<size_t>(prefix_blocks) * stride;
+		}
+
+		m_stride        = stride;
+		m_block_count   = block_count;
+		m_prefix_blocks = prefix_blocks;
+		m_proxy_index   = proxy_index;
+		m_write_header  = write_header;
+
+		rewind();
+	}
+
+	[[nodiscard]] inline uint32_t stride() const noexcept
+	{ return m_stride; }
+
+	[[nodiscard]] inline uint32_t block_count() const noexcept
+	{ return m_block_count; }
 };
-} // mtp::core
 
+} // mtp::core
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "freelist.hpp"
 #include "metapool_config.hpp"
 
 
@@ -16,48 +17,53 @@ public:
 
 	FreelistProxy() = delete;
 
-	[[nodiscard]] inline std::byte* fetch() const
+	inline void reset() const noexcept
 	{
-		return fn_fetch(m_freelist_ptr);
+		m_freelist_ptr->reset();
 	}
 
-	inline void release(std::byte* block) const
+	[[nodiscard]] inline std::byte* carve() const noexcept
 	{
-		fn_release(m_freelist_ptr, block);
+		return m_freelist_ptr->carve();
 	}
 
-	inline void reset() const
+	[[nodiscard]] inline std::byte* carve_shared() const noexcept
 	{
-		fn_reset(m_freelist_ptr);
+		return m_freelist_ptr->carve_shared();
 	}
 
-private:
+	inline void extend(std::byte* memory, size_t bytes) const noexcept
+	{
+		m_freelist_ptr->extend(memory, bytes);
+	}
+
+	[[nodiscard]] inline bool can_carve() const noexcept
+	{
+		return m_freelist_ptr->can_carve();
+	}
+
+	[[nodiscard]] inline bool can_carve_shared() const noexcept
+	{
+		return m_freelist_ptr->can_carve_shared();
+	}
 
-	using FreelistFetch   = std::byte* (*)(void*);
-	using FreelistRelease = void (*)(void*, std::byte*);
-	using FreelistReset   = void (*)(void*);
+	[[nodiscard]] inline bool owns(const std::byte* block) const noexcept
+	{
+		return m_freelist_ptr->owns(block);
+	}
 
-	void*           m_freelist_ptr  {nullptr};
-	FreelistFetch   fn_fetch        {nullptr};
-	FreelistRelease fn_release      {nullptr};
-	FreelistReset   fn_reset        {nullptr};
+private:
+
+	FreelistBase* m_freelist_ptr {nullptr};
 
 
 	template <mtp::cfg::IsMetapoolConfig>
 	friend class Metapool;
 
 
-	FreelistProxy(
-		void*           ptr,
-		FreelistFetch   fetch,
-		FreelistRelease release,
-		FreelistReset   reset)
-			: m_freelist_ptr {ptr}
-			, fn_fetch       {fetch}
-			, fn_release     {release}
-			, fn_reset       {reset}
+	explicit FreelistProxy(FreelistBase* ptr)
+		: m_freelist_ptr {ptr}
 	{}
 };
 
 } // mtp::core
-
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <new>
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+#include "allocator.hpp"
+#include "memory_model.hpp"
+
+#include "fail.hpp"
+
+
+namespace mtp::core {
+
+
+// per-thread front of a lock-free shared allocator: every stride caches up to its magazine size of blocks
+// in a plain array, refilled from and flushed to the shared freelists half a magazine at a time
+
+template <typename Set>
+class MagazineCache final
+{
+public:
+
+	using core_t        = AllocatorCore<mtp::cfg::ConcurrentConfig<decltype(Set::create_allocator_config())>>;
+	using config_t      = typename core_t::config_type;
+	using proxy_index_t = typename core_t::proxy_index_t;
+
+	template <mtp::cfg::AllocatorTag Tag>
+	explicit MagazineCache(MemoryModel::Shared<Set, Tag, mtp::cfg::SharedPolicy::lock_free>& shared) noexcept
+		: m_core {shared.get_ptr()}
+	{}
+
+	~MagazineCache()
+	{
+		flush();
+	}
+
+	MagazineCache(const MagazineCache&) = delete;
+	MagazineCache& operator=(const MagazineCache&) = delete;
+
+	MagazineCache(MagazineCache&&) = delete;
+	MagazineCache& operator=(MagazineCache&&) = delete;
+
+public:
+
+	[[nodiscard]] inline std::byte* alloc(uint32_t size, uint32_t alignment)
+	{
+		MTP_ASSERT(size > 0,
+			mtp::err::alloc_zero_size);
+
+		const proxy_index_t proxy_index = core_t::lookup(size, alignment);
+
+		MTP_ASSERT(proxy_index < config_t::total_stride_count,
+			mtp::err::alloc_proxy_oob);
+
+		std::byte* block = nullptr;
+
+		if (m_counts[proxy_index] != 0) [[likely]]
+			block = m_slots[magazine_offsets[proxy_index] + --m_counts[proxy_index]];
+		else
+			block = refill(proxy_index);
+
+		if (block == nullptr) [[unlikely]]
+			block = m_core->fetch_fallback(size, alignment, proxy_index, mtp::err::alloc_proxy_oob);
+
+		mtp::cfg::AllocRecorder::record_alloc(m_core->m_heads.data(), block, size, alignment, proxy_index);
+
+		return block;
+	}
+
+
+	[[nodiscard]] inline std::byte* try_alloc(uint32_t size, uint32_t alignment) noexcept
+	{
+		MTP_ASSERT(size > 0,
+			mtp::err::alloc_zero_size);
+
+		const proxy_index_t proxy_index = core_t::resolve_unchecked(size, alignment);
+
+		if (proxy_index >= config_t::total_stride_count) [[unlikely]]
+			return nullptr;
+
+		mtp::cfg::AllocTracer::trace(size, alignment, config_t::proxy_strides[proxy_index], proxy_index);
+
+		std::byte* block = nullptr;
+
+		if (m_counts[proxy_index] != 0) [[likely]]
+			block = m_slots[magazine_offsets[proxy_index] + --m_counts[proxy_index]];
+		else
+			block = refill(proxy_index);
+
+		if (block == nullptr) [[unlikely]]
+			block = m_core->try_fetch_fallback(size, alignment, proxy_index);
+
+		mtp::cfg::AllocRecorder::record_alloc(m_core->m_heads.data(), block, size, alignment, proxy_index);
+
+		return block;
+	}
+
+
+	inline void free(std::byte* block)
+	{
+		if (block == nullptr) [[unlikely]]
+			return;
+
+		mtp::cfg::AllocRecorder::record_free(m_core->m_heads.data(), block);
+
+		const proxy_index_t proxy_index = m_core->proxy_of(block);
+
+		MTP_ASSERT(proxy_index < config_t::total_stride_count,
+			mtp::err::free_proxy_oob);
+		MTP_ASSERT(m_core->m_proxies[proxy_index].owns(block),
+			mtp::err::release_block_outside);
+
+		if constexpr (magazine_slot_count == 0) {
+			m_core->push(proxy_index, block);
+		}
+		else {
+			const uint32_t capacity = Set::proxy_magazine_sizes[proxy_index];
+
+			if (capacity == 0) [[unlikely]] {
+				m_core->push(proxy_index, block);
+				return;
+			}
+
+			if (m_counts[proxy_index] == capacity) [[unlikely]]
+				flush(proxy_index, std::max(capacity / 2U, 1U));
+
+			m_slots[magazine_offsets[proxy_index] + m_counts[proxy_index]++] = block;
+		}
+	}
+
+
+	template <typename T, typename... Types>
+	[[nodiscard]] inline T* construct(Types&&... args)
+	{
+		std::byte* block = alloc(sizeof(T), alignof(T));
+
+		return std::launder(new (block) T(std::forward<Types>(args)...));
+	}
+
+
+	template <typename T>
+	inline void destruct(T* object)
+	{
+		if (object == nullptr) [[unlikely]]
+			return;
+
+		object->~T();
+
+		free(reinterpret_cast<std::byte*>(object));
+	}
+
+	// returns every cached block to the shared freelists
+
+	inline void flush() noexcept
+	{
+		for (size_t index = 0; index < config_t::total_stride_count; ++index) {
+			if (m_counts[index] != 0)
+				flush(static_cast<proxy_index_t>(index), m_counts[index]);
+		}
+	}
+
+	// forgets cached blocks without returning them, for use after the shared allocator was reset
+
+	inline void discard() noexcept
+	{
+		m_counts.fill(0);
+	}
+
+	// same after a reset_metapool<Index>() or reset_range() of the shared allocator, other strides stay cached
+
+	template <size_t Index>
+	inline void discard_metapool() noexcept
+	{
+		constexpr auto& range = config_t::range_metadata[config_t::metapool_order[Index]];
+
+		std::fill_n(m_counts.begin() + range.base_proxy_index, range.stride_count, 0U);
+	}
+
+	inline void discard_range(uint32_t stride_lo, uint32_t stride_hi) noexcept
+	{
+		for (size_t index = 0; index < config_t::total_stride_count; ++index) {
+			if (config_t::proxy_strides[index] >= stride_lo && config_t::proxy_strides[index] <= stride_hi)
+				m_counts[index] = 0;
+		}
+	}
+
+private:
+
+	static constexpr auto magazine_offsets = [] {
+		std::array<uint32_t, config_t::total_stride_count + 1> offsets {};
+
+		for (size_t i = 0; i < config_t::total_stride_count; ++i)
+			offsets[i + 1] = offsets[i] + Set::proxy_magazine_sizes[i];
+
+		return offsets;
+	}();
+
+	static constexpr size_t magazine_slot_count = magazine_offsets.back();
+
+	// an empty magazine takes half its capacity in one transfer, carving never-used blocks if the stack runs dry
+
+	[[nodiscard]] inline std::byte* refill(proxy_index_t proxy_index) noexcept
+	{
+		const uint32_t capacity = Set::proxy_magazine_sizes[proxy_index];
+
+		if (capacity == 0) [[unlikely]]
+			return m_core->take(proxy_index);
+
+		std::byte** slots = m_slots.data() + magazine_offsets[proxy_index];
+
+		const size_t taken = m_core->take_run(proxy_index, std::max(capacity / 2U, 1U), slots);
+
+		if (taken == 0) [[unlikely]]
+			return nullptr;
+
+		m_counts[proxy_index] = static_cast<uint32_t>(taken - 1);
+
+		return slots[taken - 1];
+	}
+
+	// the oldest blocks go back with one exchange, the recently freed ones stay cached
+
+	inline void flush(proxy_index_t proxy_index, uint32_t count) noexcept
+	{
+		std::byte** slots = m_slots.data() + magazine_offsets[proxy_index];
+
+		for (uint32_t i = 0; i + 1 < count; ++i)
+			reinterpret_cast<FreeBlock*>(slots[i])->next = reinterpret_cast<FreeBlock*>(slots[i + 1]);
+
+		m_core->splice(
+			proxy_index,
+			reinterpret_cast<FreeBlock*>(slots[0]),
+			reinterpret_cast<FreeBlock*>(slots[count - 1]),
+			count
+		);
+
+		const uint32_t remaining = m_counts[proxy_index] - count;
+
+		std::memmove(slots, slots + count, remaining * sizeof(std::byte*));
+
+		m_counts[proxy_index] = remaining;
+	}
+
+private:
+
+	core_t* m_core {nullptr};
+
+	std::array<uint32_t, config_t::total_stride_count> m_counts {};
+
+	std::array<std::byte*, magazine_slot_count> m_slots {};
+};
+
+} // mtp::core
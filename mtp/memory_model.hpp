@@ -2,13 +2,18 @@
 
 #include "mtpint.hpp"
 
+#include <new>
 #include <span>
 #include <tuple>
 #include <array>
+#include <atomic>
 #include <memory>
 
 #include "allocator.hpp"
 #include "metaset.hpp"
+#include "page_map.hpp"
+#include "remote_queue.hpp"
+#include "overflow_arena.hpp"
 #include "monotonic_arena.hpp"
 
 #include "fail.hpp"
@@ -23,6 +28,11 @@ namespace mtp::cfg {
 		pmr_adapter
 	};
 
+	enum class SharedPolicy {
+		exclusive,  // one thread at a time, callers synchronize externally
+		lock_free   // tagged Treiber stacks, safe to share across threads without a lock
+	};
+
 } // mtp::cfg
 
 
@@ -36,34 +46,22 @@ public:
 	MemoryModel() = delete;
 
 
+	// the thread's allocator lives in a leased state; a thread without one adopts a recycled state or builds one
+
 	template <typename Set, mtp::cfg::AllocatorTag Tag>
 	static inline auto& create_thread_local_allocator()
 	{
-		thread_local static MonotonicArena arena {
-			Set::arena_size,
-			mtp::cfg::arena_alignment
-		};
-
-		thread_local static MetapoolContainer<Set> container {&arena};
-
-		thread_local static std::array<std::byte, k_proxy_buffer_bytes<Set>> proxy_buffer {};
-
-		thread_local static auto proxies = setup_proxy_span<Set>(container, proxy_buffer);
+		return thread_lease<Set, Tag>().allocator();
+	}
 
-		constexpr auto allocator_config = Set::create_allocator_config();
+	// returns the calling thread's states for the set to the recycler, the next use adopts a fresh lease
 
-		if constexpr (Tag == mtp::cfg::AllocatorTag::native) {
-			thread_local static Allocator<decltype(allocator_config), Native> allocator {proxies};
-			return allocator;
-		}
-		else if constexpr (Tag == mtp::cfg::AllocatorTag::std_adapter) {
-			thread_local static Allocator<decltype(allocator_config), StdAdapter, void> allocator {proxies};
-			return allocator;
-		}
-		else if constexpr (Tag == mtp::cfg::AllocatorTag::pmr_adapter) {
-			thread_local static Allocator<decltype(allocator_config), PmrAdapter> allocator {proxies};
-			return allocator;
-		}
+	template <typename Set>
+	static inline void release_thread_local() noexcept
+	{
+		thread_lease<Set, mtp::cfg::AllocatorTag::native>().release();
+		thread_lease<Set, mtp::cfg::AllocatorTag::std_adapter>().release();
+		thread_lease<Set, mtp::cfg::AllocatorTag::pmr_adapter>().release();
 	}
 
 private:
@@ -73,11 +71,13 @@ private:
 	{
 	public:
 
-		explicit MetapoolContainer(MonotonicArena* upstream)
+		MetapoolContainer(MonotonicArena* upstream, PageMap& page_map, MonotonicArena& packed)
 			: m_metapool_storage
 		{
 			create_storage(
 				upstream,
+				Set::header_free ? &page_map : nullptr,
+				Set::packed ? &packed : nullptr,
 				Set::create_allocator_config(),
 				std::make_index_sequence<Set::set_size>{}
 			)
@@ -89,6 +89,8 @@ private:
 		template <typename Config, size_t... Is>
 		static auto create_storage(
 			MonotonicArena* upstream,
+			PageMap* page_map,
+			MonotonicArena* packed,
 			const Config& config,
 			std::index_sequence<Is...>
 		)
@@ -96,7 +98,11 @@ private:
 			return std::make_tuple(
 				std::tuple_element_t<Is, typename Set::TupleType>(
 					upstream,
-					config.range_metadata[Set::sorted_index_map[Is]].base_proxy_index
+					config.range_metadata[Set::sorted_index_map[Is]].base_proxy_index,
+					page_map,
+					packed,
+					Set::options.pack_stride_limit,
+					Set::options.pack_bytes
 				)...
 			);
 		}
@@ -116,26 +122,22 @@ private:
 
 			auto* proxy_ptr = reinterpret_cast<FreelistProxy*>(raw_buffer);
 
-			size_t offset = 0;
+			// tuple order is declaration order, proxy slots follow the stride-sorted metadata
 
 			const auto fill_proxies = []<size_t... Is>(
 				std::index_sequence<Is...>,
 				std::tuple<std::tuple_element_t<Is, typename Set::TupleType>...>& pools,
 				FreelistProxy* out_ptr,
-				size_t& base_offset,
 				const std::array<mtp::cfg::RangeMetadata, Set::set_size>& metadata
 			) {
 				(..., (
 					std::get<Is>(pools).make_freelist_proxies(
-						reinterpret_cast<FreelistProxy*>(
-							reinterpret_cast<std::byte*>(out_ptr) + base_offset
-						)
-					),
-					base_offset += metadata[Is].stride_count * sizeof(FreelistProxy)
+						out_ptr + metadata[Set::sorted_index_map[Is]].base_proxy_index
+					)
 				));
 			};
 
-			fill_proxies(std::make_index_sequence<Set::set_size>{}, m_metapool_storage, proxy_ptr, offset, metadata);
+			fill_proxies(std::make_index_sequence<Set::set_size>{}, m_metapool_storage, proxy_ptr, metadata);
 
 			return std::span<FreelistProxy>{proxy_ptr, total_stride_count};
 		}
@@ -156,18 +158,45 @@ private:
 	static constexpr size_t k_proxy_buffer_bytes =
 		alignof(FreelistProxy) + k_proxy_bytes<Set>;
 
+	template <typename Set>
+	using FreelistHeads = std::array<FreeBlock*, Set::create_allocator_config().total_stride_count>;
+
+	template <typename Set>
+	using SharedHeads = std::array<SharedHead, Set::create_allocator_config().total_stride_count>;
+
+	template <typename Set>
+	using FreelistCounters = std::array<ProxyCounters, Set::create_allocator_config().total_stride_count>;
+
+	template <typename Set>
+	using SharedCounterArray = std::array<SharedCounters, Set::create_allocator_config().total_stride_count>;
+
+	template <typename Set>
+	using FreelistOccupancy = std::array<uint64_t, (Set::create_allocator_config().total_stride_count + 63U) / 64U>;
+
 public:
 
-	template <typename Set, mtp::cfg::AllocatorTag Tag = mtp::cfg::AllocatorTag::std_adapter>
+	template <
+		typename Set,
+		mtp::cfg::AllocatorTag Tag    = mtp::cfg::AllocatorTag::std_adapter,
+		mtp::cfg::SharedPolicy Policy = mtp::cfg::SharedPolicy::exclusive
+	>
 	class Shared final
 	{
 	public:
 
-		Shared()
-			: m_arena     {Set::arena_size, mtp::cfg::arena_alignment}
-			, m_container {&m_arena}
+		// the commit policy defaults to the one in the set options and can be chosen per instance
+
+		explicit Shared(
+			mtp::cfg::CommitPolicy commit           = Set::options.commit,
+			uint32_t               prefault_threads = Set::options.prefault_threads
+		)
+			: m_arena     {Set::arena_size, mtp::cfg::arena_alignment, commit, prefault_threads, Set::options.huge_pages}
+			, m_page_map  {make_page_map<Set>(m_arena)}
+			, m_packed    {make_pack_region<Set>(m_arena)}
+			, m_container {&m_arena, m_page_map, m_packed}
+			, m_overflow  {Set::options.elastic_segment_bytes}
 			, m_proxies   {setup_proxy_span<Set>(m_container, m_proxy_buffer)}
-			, m_allocator {m_proxies}
+			, m_allocator {m_heads, m_counters, m_occupancy, m_proxies, m_page_map, &m_overflow, m_arena.base()}
 		{}
 
 		Shared(const Shared&) = delete;
@@ -186,6 +215,122 @@ public:
 			return &m_allocator;
 		}
 
+		[[nodiscard]] auto stats() const noexcept
+		{
+			return m_allocator.stats();
+		}
+
+	private:
+
+		using allocator_config_t =
+			std::conditional_t <
+				Policy == mtp::cfg::SharedPolicy::lock_free,
+				mtp::cfg::ConcurrentConfig<decltype(Set::create_allocator_config())>,
+				decltype(Set::create_allocator_config())
+			>;
+
+		using heads_t =
+			std::conditional_t <
+				Policy == mtp::cfg::SharedPolicy::lock_free,
+				SharedHeads<Set>,
+				FreelistHeads<Set>
+			>;
+
+		using counters_t =
+			std::conditional_t <
+				Policy == mtp::cfg::SharedPolicy::lock_free,
+				SharedCounterArray<Set>,
+				FreelistCounters<Set>
+			>;
+
+		using allocator_t =
+			std::conditional_t <
+				Tag == mtp::cfg::AllocatorTag::native,
+				Allocator<allocator_config_t, Native>,
+				std::conditional_t <
+					Tag == mtp::cfg::AllocatorTag::std_adapter,
+					Allocator<allocator_config_t, StdAdapter, void>,
+					Allocator<allocator_config_t, PmrAdapter>
+				>
+			>;
+
+	private:
+
+		MonotonicArena m_arena;
+
+		PageMap m_page_map;
+
+		MonotonicArena m_packed;
+
+		MetapoolContainer<Set> m_container;
+
+		std::array<std::byte, k_proxy_buffer_bytes<Set>> m_proxy_buffer {};
+
+		alignas(std::hardware_destructive_interference_size) heads_t m_heads {};
+
+		counters_t m_counters {};
+
+		FreelistOccupancy<Set> m_occupancy {};
+
+		OverflowArena m_overflow;
+
+		std::span<FreelistProxy> m_proxies;
+
+		allocator_t m_allocator;
+	};
+
+private:
+
+	// one thread's arena with everything built on it, kept in one piece so it can outlive the thread
+
+	template <typename Set, mtp::cfg::AllocatorTag Tag>
+	class ThreadState final
+	{
+	public:
+
+		ThreadState()
+			: m_arena     {Set::arena_size, mtp::cfg::arena_alignment, Set::options.commit, Set::options.prefault_threads, Set::options.huge_pages}
+			, m_page_map  {make_page_map<Set>(m_arena)}
+			, m_packed    {make_pack_region<Set>(m_arena)}
+			, m_container {&m_arena, m_page_map, m_packed}
+			, m_overflow  {Set::options.elastic_segment_bytes}
+			, m_remote    {m_arena.base(), m_arena.size(), &m_overflow}
+			, m_proxies   {setup_proxy_span<Set>(m_container, m_proxy_buffer)}
+			, m_allocator {m_heads, m_counters, m_occupancy, m_proxies, m_page_map, &m_overflow, m_arena.base(), &m_remote}
+		{}
+
+		ThreadState(const ThreadState&) = delete;
+		ThreadState& operator=(const ThreadState&) = delete;
+
+		ThreadState(ThreadState&&) = delete;
+		ThreadState& operator=(ThreadState&&) = delete;
+
+		[[nodiscard]] auto& allocator() noexcept
+		{
+			return m_allocator;
+		}
+
+		// a retired state stops taking remote frees and is rewound, the next owner starts from a clean arena
+		// only a state whose blocks all came back can be recycled: a block still out could be freed into the next
+		// owner's queue after that owner handed the same block out again, so such a state is refused
+
+		[[nodiscard]] inline bool retire() noexcept
+		{
+			m_remote.withdraw();
+
+			if (m_allocator.live_blocks() != 0) [[unlikely]]
+				return false;
+
+			m_allocator.reset();
+
+			return true;
+		}
+
+		inline void adopt()
+		{
+			m_remote.enroll();
+		}
+
 	private:
 
 		using allocator_config_t = decltype(Set::create_allocator_config());
@@ -205,15 +350,148 @@ public:
 
 		MonotonicArena m_arena;
 
+		PageMap m_page_map;
+
+		MonotonicArena m_packed;
+
 		MetapoolContainer<Set> m_container;
 
 		std::array<std::byte, k_proxy_buffer_bytes<Set>> m_proxy_buffer {};
 
+		alignas(std::hardware_destructive_interference_size) FreelistHeads<Set> m_heads {};
+
+		FreelistCounters<Set> m_counters {};
+
+		FreelistOccupancy<Set> m_occupancy {};
+
+		OverflowArena m_overflow;
+
+		RemoteQueue<allocator_config_t> m_remote;
+
 		std::span<FreelistProxy> m_proxies;
 
 		allocator_t m_allocator;
 	};
 
+	// process-wide recycler of retired thread states, one slot array per set and tag
+	// slots are taken with an exchange and filled with a compare-exchange, so no state is handed out twice
+
+	template <typename State>
+	class StatePool final
+	{
+	public:
+
+		static constexpr size_t capacity = 64U;
+
+		StatePool() = delete;
+
+		[[nodiscard]] static inline State* adopt() noexcept
+		{
+			for (auto& slot : s_slots.states) {
+				if (slot.load(std::memory_order_relaxed) == nullptr)
+					continue;
+
+				if (State* state = slot.exchange(nullptr, std::memory_order_acquire))
+					return state;
+			}
+
+			return nullptr;
+		}
+
+		[[nodiscard]] static inline bool retire(State* state) noexcept
+		{
+			for (auto& slot : s_slots.states) {
+				State* expected = nullptr;
+
+				if (slot.compare_exchange_strong(expected, state, std::memory_order_release, std::memory_order_relaxed))
+					return true;
+			}
+
+			return false;
+		}
+
+	private:
+
+		struct Slots
+		{
+			std::array<std::atomic<State*>, capacity> states {};
+
+			~Slots()
+			{
+				for (auto& slot : states)
+					delete slot.exchange(nullptr, std::memory_order_acquire);
+			}
+		};
+
+		inline static Slots s_slots {};
+	};
+
+	template <typename Set, mtp::cfg::AllocatorTag Tag>
+	class ThreadLease final
+	{
+	public:
+
+		ThreadLease() noexcept = default;
+
+		~ThreadLease()
+		{
+			release();
+		}
+
+		ThreadLease(const ThreadLease&) = delete;
+		ThreadLease& operator=(const ThreadLease&) = delete;
+
+		ThreadLease(ThreadLease&&) = delete;
+		ThreadLease& operator=(ThreadLease&&) = delete;
+
+		[[nodiscard]] inline auto& allocator()
+		{
+			if (m_state == nullptr) [[unlikely]]
+				acquire();
+
+			return m_state->allocator();
+		}
+
+		inline void release() noexcept
+		{
+			if (m_state == nullptr)
+				return;
+
+			// a state with live blocks is left mapped and never reused, the blocks stay valid until the process exits
+
+			if (m_state->retire()) [[likely]] {
+				if (!pool_t::retire(m_state)) [[unlikely]]
+					delete m_state;
+			}
+
+			m_state = nullptr;
+		}
+
+	private:
+
+		using state_t = ThreadState<Set, Tag>;
+		using pool_t  = StatePool<state_t>;
+
+		inline void acquire()
+		{
+			m_state = pool_t::adopt();
+
+			if (m_state != nullptr)
+				m_state->adopt();
+			else
+				m_state = new state_t();
+		}
+
+		state_t* m_state {nullptr};
+	};
+
+	template <typename Set, mtp::cfg::AllocatorTag Tag>
+	static inline ThreadLease<Set, Tag>& thread_lease() noexcept
+	{
+		thread_local static ThreadLease<Set, Tag> lease;
+		return lease;
+	}
+
 public:
 
 	template <typename T, typename Set>
@@ -223,10 +501,10 @@ public:
 		return typename std::remove_reference_t<decltype(base)>::template rebind_t<T>{base};
 	}
 
-	template <typename T, typename Set>
+	template <typename T, typename Set, mtp::cfg::SharedPolicy Policy>
 	static inline auto get_std_adapter(
 		mtp::core::MemoryModel::Shared<Set,
-		mtp::cfg::AllocatorTag::std_adapter>& shared
+		mtp::cfg::AllocatorTag::std_adapter, Policy>& shared
 	)
 	{
 		auto& base = shared.get();
@@ -240,10 +518,10 @@ public:
 		return std::pmr::polymorphic_allocator<T>{static_cast<std::pmr::memory_resource*>(&base)};
 	}
 
-	template <typename T, typename Set>
+	template <typename T, typename Set, mtp::cfg::SharedPolicy Policy>
 	static inline auto get_pmr_adapter(
 		mtp::core::MemoryModel::Shared<Set,
-		mtp::cfg::AllocatorTag::pmr_adapter>& shared
+		mtp::cfg::AllocatorTag::pmr_adapter, Policy>& shared
 	)
 	{
 		auto& base = shared.get();
@@ -254,8 +532,48 @@ public:
 
 private:
 
+	template <typename Set>
+	[[nodiscard]] static PageMap make_page_map(MonotonicArena& arena)
+	{
+		if constexpr (Set::header_free) {
+
+			// the table takes the first pages of the arena, the pools follow it
+
+			std::byte* table = arena.fetch(Set::page_map_bytes, PageMap::page_size, 0);
+
+			return PageMap {
+				table + Set::page_map_bytes,
+				reinterpret_cast<PageMap::proxy_index_t*>(table),
+				PageMap::pages_for(Set::pool_bytes)
+			};
+		}
+		else {
+			return PageMap {};
+		}
+	}
+
+	template <typename Set>
+	[[nodiscard]] static MonotonicArena make_pack_region(MonotonicArena& arena)
+	{
+		if constexpr (Set::packed) {
+
+			// packed prefixes follow the page map, so they open the arena's first (huge) page
+
+			return MonotonicArena {
+				arena.fetch(Set::pack_region_bytes, PageMap::page_size, 0),
+				Set::pack_region_bytes
+			};
+		}
+		else {
+			return MonotonicArena {nullptr, 0};
+		}
+	}
+
 	template <typename Set, typename ProxyBuffer>
-	[[nodiscard]] static auto setup_proxy_span(MetapoolContainer<Set>& container, ProxyBuffer& proxy_buffer)
+	[[nodiscard]] static auto setup_proxy_span(
+		MetapoolContainer<Set>& container,
+		ProxyBuffer& proxy_buffer
+	)
 	{
 		void* buffer_ptr    = static_cast<void*>(proxy_buffer.data());
 		size_t buffer_bytes = proxy_buffer.size();
@@ -290,5 +608,13 @@ namespace mtp::cfg {
 	template <typename T, typename Set>
 	using rebound_std_adapter = typename alloc_for<Set>::template rebind_t<T>;
 
+	template <typename Set, SharedPolicy Policy = SharedPolicy::exclusive>
+	using shared_alloc_for = std::remove_reference_t<decltype(
+		std::declval<mtp::core::MemoryModel::Shared<Set, AllocatorTag::std_adapter, Policy>&>().get()
+	)>;
+
+	template <typename T, typename Set, SharedPolicy Policy = SharedPolicy::exclusive>
+	using rebound_shared_adapter = typename shared_alloc_for<Set, Policy>::template rebind_t<T>;
+
 } // mtp::cfg
 
@@ -3,10 +3,10 @@
 #include "mtpint.hpp"
 
 #include <array>
-#include <variant>
 #include <algorithm>
 
 #include "freelist.hpp"
+#include "page_map.hpp"
 #include "freelist_proxy.hpp"
 #include "monotonic_arena.hpp"
 #include "metapool_config.hpp"
@@ -30,34 +30,62 @@ public:
 	Metapool(Metapool&& other) noexcept = default;
 	Metapool& operator=(Metapool&& other) noexcept = default;
 
-	using proxy_index_t = typename mtp::core::Freelist <
-		Config::stride_pivots.front(),
-		Config::base_block_count
-	>::proxy_index_t;
+	using proxy_index_t = typename mtp::core::Freelist::proxy_index_t;
 
-	explicit Metapool(MonotonicArena* upstream, proxy_index_t base_proxy_index)
+	explicit Metapool(
+		MonotonicArena* upstream,
+		proxy_index_t   base_proxy_index,
+		PageMap*        page_map          = nullptr,
+		MonotonicArena* packed            = nullptr,
+		uint32_t        pack_stride_limit = 0,
+		uint32_t        pack_bytes        = 0
+	)
 		: m_upstream {upstream}
 	{
 		MTP_ASSERT(upstream != nullptr,
 			mtp::err::metapool_upstream_null);
+
+		// without a page map every block carries its proxy index in the 2 bytes in front of it
+
+		const bool write_header = page_map == nullptr;
+		const size_t shift = write_header ? sizeof(proxy_index_t) : 0;
+
+		if (packed == nullptr)
+			pack_stride_limit = 0;
 	
 		for (proxy_index_t pool_index = 0; pool_index < static_cast<proxy_index_t>(m_pools.size()); ++pool_index) {
-			auto& pool = m_pools[pool_index];
-			size_t pool_size = pool.stride * pool.block_count;
+			const uint32_t stride      = MetapoolStatic::strides[pool_index];
+			const uint32_t block_count = MetapoolStatic::block_counts[pool_index];
+
+			const uint32_t prefix_blocks = MetapoolTraits::packed_block_count(pool_index, pack_stride_limit, pack_bytes);
+
+			std::byte* prefix_memory = prefix_blocks == 0 ? nullptr : packed->fetch(
+				static_cast<size_t>(stride) * prefix_blocks,
+				mtp::cfg::MetapoolConstraints::block_alignment(stride),
+				shift
+			);
+
+			size_t pool_size = static_cast<size_t>(stride) * (block_count - prefix_blocks);
 	
 			std::byte* pool_memory = m_upstream->fetch(
 				pool_size,
 				mtp::cfg::MetapoolConstraints::freelist_alignment,
-				sizeof(proxy_index_t)
+				shift
 			);
 	
 			const proxy_index_t proxy_index = base_proxy_index + pool_index;
+
+			if (!write_header)
+				page_map->assign(pool_memory, pool_size, proxy_index);
 	
-			std::visit(
-				[pool_memory, proxy_index](auto& freelist) {
-					freelist.initialize(pool_memory, proxy_index);
-				},
-				pool.freelist
+			m_pools[pool_index].initialize(
+				pool_memory,
+				stride,
+				block_count,
+				proxy_index,
+				write_header,
+				prefix_memory,
+				prefix_blocks
 			);
 		}
 	}
@@ -75,40 +103,16 @@ private:
 			};
 		}(std::make_index_sequence<stride_count>{});
 
-		static constexpr auto block_counts = [] {
-			std::array<uint32_t, stride_count> blocks_per_stride {};
-			uint32_t curr_count = Config::base_block_count;
+		static constexpr auto& block_counts = Config::block_counts;
 
-			for (size_t i = 0; i < stride_count; ++i) {
-				blocks_per_stride[i] = curr_count;
-
-				if (i + 1 < stride_count &&
-					std::find(
-						Config::stride_pivots.begin() + 1,
-						Config::stride_pivots.end(),
-						strides[i + 1])
-							!= Config::stride_pivots.end()
-				) {
-					switch (Config::capacity_function) {
-						case mtp::cfg::CapacityFunction::div8:
-							curr_count = std::max(curr_count / 8U, mtp::cfg::MetapoolConstraints::min_last_block_count);
-							break;
-						case mtp::cfg::CapacityFunction::div4:
-							curr_count = std::max(curr_count / 4U, mtp::cfg::MetapoolConstraints::min_last_block_count);
-							break;
-						case mtp::cfg::CapacityFunction::div2:
-							curr_count = std::max(curr_count / 2U, mtp::cfg::MetapoolConstraints::min_last_block_count);
-							break;
-						case mtp::cfg::CapacityFunction::flat: break;
-						case mtp::cfg::CapacityFunction::mul2: curr_count *= 2U; break;
-						case mtp::cfg::CapacityFunction::mul4: curr_count *= 4U; break;
-						case mtp::cfg::CapacityFunction::mul8: curr_count *= 8U; break;
-					}
-				}
-			}
-	
-			return blocks_per_stride;
-		}();
+		static_assert(block_counts.size() == stride_count,
+			CONFIG_BLOCK_COUNT_SIZE_MSG);
+
+		static_assert(Config::stride_pivots.front() >= sizeof(void*),
+			FREELIST_STRIDE_TOO_SMALL_MSG);
+
+		static_assert(sizeof(FreeBlock) <= Config::stride_pivots.front(),
+			FREELIST_BLOCK_TOO_LARGE_MSG);
 	};
 
 public:
@@ -120,6 +124,28 @@ public:
 		static constexpr uint32_t stride_step  = Config::stride_step;
 		static constexpr uint32_t stride_count = MetapoolStatic::stride_count;
 
+		static constexpr auto& strides      = MetapoolStatic::strides;
+		static constexpr auto& block_counts = MetapoolStatic::block_counts;
+
+		static constexpr auto magazine_sizes = [] {
+			std::array<uint32_t, stride_count> sizes {};
+
+			for (size_t i = 0; i < stride_count; ++i) {
+				if constexpr (Config::magazine_size == mtp::cfg::MetapoolConstraints::auto_magazine_size) {
+					sizes[i] = std::min({
+						mtp::cfg::MetapoolConstraints::magazine_bytes / MetapoolStatic::strides[i],
+						mtp::cfg::MetapoolConstraints::max_auto_magazine,
+						MetapoolStatic::block_counts[i] / 4U
+					});
+				}
+				else {
+					sizes[i] = std::min(Config::magazine_size, MetapoolStatic::block_counts[i]);
+				}
+			}
+
+			return sizes;
+		}();
+
 		static constexpr size_t reserved_bytes = []() constexpr {
 			size_t sum = 0;
 
@@ -130,116 +156,44 @@ public:
 
 			return sum + stride_count * mtp::cfg::MetapoolConstraints::freelist_alignment;
 		}();
-	};
-
-	static constexpr auto& compute_pools()
-	{
-		static constexpr std::array<Pool, MetapoolTraits::stride_count> pools =
-			[]<size_t... Is>(std::index_sequence<Is...>) {
-				return std::array<Pool, MetapoolTraits::stride_count> {{
-
-					Pool {
-						MetapoolStatic::strides[Is],
-						MetapoolStatic::block_counts[Is],
-						&freelist_typed_fetch  <MetapoolStatic::strides[Is], MetapoolStatic::block_counts[Is]>,
-						&freelist_typed_release<MetapoolStatic::strides[Is], MetapoolStatic::block_counts[Is]>,
-						&freelist_typed_reset  <MetapoolStatic::strides[Is], MetapoolStatic::block_counts[Is]>,
-						Freelist<MetapoolStatic::strides[Is], MetapoolStatic::block_counts[Is]> {}
-					}...
-
-				}};
-			}(std::make_index_sequence<MetapoolTraits::stride_count> {});
-
-		return pools;
-	}
-
-private:
-
-	template <const auto& Strides, const auto& BlockCount, typename IndexSequence>
-	struct FreelistGenerator;
-
-	template <const auto& Strides, const auto& BlockCount, uint32_t... Is>
-	struct FreelistGenerator<Strides, BlockCount, std::index_sequence<Is...>>
-	{
-		using type = std::variant<Freelist<Strides[Is], BlockCount[Is]>...>;
-	};
 
-	using FreelistVariant =
-		typename FreelistGenerator <
-			MetapoolStatic::strides,
-			MetapoolStatic::block_counts,
-			std::make_index_sequence<MetapoolTraits::stride_count>
-		>::type;
-
-	using FreelistFetch = std::byte* (*)(void* freelist);
-	using FreelistRelease = void (*)(void* freelist, std::byte* block);
-	using FreelistReset = void (*)(void* freelist);
-
-	template <uint32_t Stride, uint32_t BlockCount>
-	[[nodiscard]] static inline std::byte* freelist_typed_fetch(void* freelist_ptr)
-	{
-		MTP_ASSERT(freelist_ptr != nullptr,
-			 mtp::err::metapool_freelist_null);
-
-		auto& freelist = *static_cast<Freelist<Stride, BlockCount>*>(freelist_ptr);
-		return freelist.fetch();
-	}
-
-	template <uint32_t Stride, uint32_t BlockCount>
-	static inline void freelist_typed_release(void* freelist_ptr, std::byte* block)
-	{
-		MTP_ASSERT(freelist_ptr != nullptr,
-			 mtp::err::metapool_freelist_null);
+		static constexpr uint32_t packed_block_count(size_t index, uint32_t stride_limit, uint32_t pack_bytes) noexcept
+		{
+			if (stride_limit == 0 || MetapoolStatic::strides[index] > stride_limit)
+				return 0;
 
-		auto& freelist = *static_cast<Freelist<Stride, BlockCount>*>(freelist_ptr);
-		freelist.release(block);
-	}
+			return std::min(MetapoolStatic::block_counts[index], std::max(1U, pack_bytes / MetapoolStatic::strides[index]));
+		}
 
-	template <uint32_t Stride, uint32_t BlockCount>
-	static inline void freelist_typed_reset(void* freelist_ptr)
-	{
-		MTP_ASSERT(freelist_ptr != nullptr,
-			 mtp::err::metapool_freelist_null);
-
-		auto& freelist = *static_cast<Freelist<Stride, BlockCount>*>(freelist_ptr);
-		return freelist.reset();
-	}
+		// upper bound of the packed region this metapool takes, including alignment and header slack
 
+		static constexpr size_t packed_bytes(uint32_t stride_limit, uint32_t pack_bytes) noexcept
+		{
+			size_t sum = 0;
 
-	struct Pool
-	{
-		uint32_t stride      {0};
-		uint32_t block_count {0};
+			for (size_t i = 0; i < stride_count; ++i) {
+				const uint32_t blocks = packed_block_count(i, stride_limit, pack_bytes);
 
-		FreelistFetch   fl_fetch   {nullptr};
-		FreelistRelease fl_release {nullptr};
-		FreelistReset   fl_reset   {nullptr};
+				if (blocks != 0)
+					sum += static_cast<size_t>(MetapoolStatic::strides[i]) * blocks +
+						mtp::cfg::MetapoolConstraints::block_alignment(MetapoolStatic::strides[i]) + sizeof(proxy_index_t);
+			}
 
-		FreelistVariant freelist;
+			return sum;
+		}
 	};
 
-public:
-
 	using config_type = Config;
-	using PoolVariant = FreelistVariant;
 
 	inline void make_freelist_proxies(mtp::core::FreelistProxy* fl_proxies_out)
 	{
-		for (uint32_t i = 0; i < MetapoolTraits::stride_count; ++i) {
-			std::visit([&](auto& freelist) {
-				new (fl_proxies_out + i) mtp::core::FreelistProxy {
-					&freelist,
-					m_pools[i].fl_fetch,
-					m_pools[i].fl_release,
-					m_pools[i].fl_reset
-				};
-			}, m_pools[i].freelist);
-		}
+		for (uint32_t i = 0; i < MetapoolTraits::stride_count; ++i)
+			new (fl_proxies_out + i) mtp::core::FreelistProxy {&m_pools[i]};
 	}
 
 private:
 
-	std::array<Pool, MetapoolTraits::stride_count> m_pools {compute_pools()};
+	std::array<Freelist, MetapoolTraits::stride_count> m_pools {};
 
 	MonotonicArena* m_upstream {nullptr};
 };
@@ -3,7 +3,9 @@
 #include "mtpint.hpp"
 
 #include <array>
+#include <algorithm>
 #include <concepts>
+#include <type_traits>
 
 
 namespace mtp::core {
@@ -25,6 +27,25 @@ struct MetapoolConstraints
 	static constexpr uint32_t min_base_block_count = 1U;
 	static constexpr uint32_t min_last_block_count = 1U;
 	static constexpr uint32_t freelist_alignment   = 4096U;
+
+	// strides are multiples of their alignment, so a range aligned to the lowest stride bit aligns every block;
+	// capped at the page, which every freelist and overflow chunk already starts on
+
+	static constexpr size_t block_alignment(uint32_t stride) noexcept
+	{
+		return std::min<size_t>(stride & (~stride + 1U), freelist_alignment);
+	}
+
+	// magazine sizing: auto caches up to magazine_bytes per stride, never more than a quarter of its blocks
+
+	static constexpr uint32_t auto_magazine_size   = 0xFFFF'FFFFU;
+	static constexpr uint32_t magazine_bytes       = 16384U;
+	static constexpr uint32_t max_auto_magazine    = 64U;
+	static constexpr uint32_t max_magazine_size    = 4096U;
+
+	// blocks per stride for types passed to metaset_for without an expected count
+
+	static constexpr uint32_t default_type_block_count = 1024U;
 };
 
 enum class CapacityFunction
@@ -140,6 +161,133 @@ struct MetapoolConfig
 	}();
 
 	static constexpr CapacityFunction capacity_function = Func;
+
+	// the count changes by the capacity function at every pivot after the first
+
+	static constexpr auto block_counts = [] {
+		std::array<uint32_t, stride_count> counts {};
+		uint32_t curr_count = BaseBlockCount;
+
+		for (size_t i = 0; i < stride_count; ++i) {
+			counts[i] = curr_count;
+
+			const uint32_t next_stride = stride_min + static_cast<uint32_t>(i + 1) * StrideStep;
+
+			if (i + 1 < stride_count &&
+				std::find(stride_pivots.begin() + 1, stride_pivots.end(), next_stride) != stride_pivots.end())
+			{
+				switch (Func) {
+					case CapacityFunction::div8:
+						curr_count = std::max(curr_count / 8U, MetapoolConstraints::min_last_block_count);
+						break;
+					case CapacityFunction::div4:
+						curr_count = std::max(curr_count / 4U, MetapoolConstraints::min_last_block_count);
+						break;
+					case CapacityFunction::div2:
+						curr_count = std::max(curr_count / 2U, MetapoolConstraints::min_last_block_count);
+						break;
+					case CapacityFunction::flat: break;
+					case CapacityFunction::mul2: curr_count *= 2U; break;
+					case CapacityFunction::mul4: curr_count *= 4U; break;
+					case CapacityFunction::mul8: curr_count *= 8U; break;
+				}
+			}
+		}
+
+		return counts;
+	}();
+
+	static constexpr uint32_t magazine_size = MetapoolConstraints::auto_magazine_size;
+};
+
+
+template <auto StrideStep, auto StrideMin, auto StrideMax>
+concept ValidStrideRange =
+	StrideStep >= MetapoolConstraints::min_stride_step &&
+	StrideStep <= MetapoolConstraints::max_stride_step &&
+	(StrideStep & (StrideStep - 1)) == 0 &&
+	StrideMin >= MetapoolConstraints::min_stride &&
+	StrideMax <= MetapoolConstraints::max_stride &&
+	StrideMin <= StrideMax &&
+	StrideMin % StrideStep == 0 &&
+	StrideMax % StrideStep == 0;
+
+
+// shared layout of metapools whose counts are given per stride instead of by a capacity function
+
+template <auto StrideStep, auto StrideMin, auto StrideMax>
+struct StrideRangeConfig
+{
+	using tag = metapool_config_tag;
+
+	static constexpr uint32_t stride_step = StrideStep;
+
+	static constexpr std::array<uint32_t, 2> stride_pivots = {StrideMin, StrideMax};
+
+	static constexpr uint32_t stride_min   = StrideMin;
+	static constexpr uint32_t stride_max   = StrideMax;
+	static constexpr uint32_t stride_count = (StrideMax - StrideMin) / StrideStep + 1;
+
+	static constexpr uint32_t magazine_size = MetapoolConstraints::auto_magazine_size;
+};
+
+
+// one block count per stride, stride_min first
+
+template <auto StrideStep, auto StrideMin, auto StrideMax, auto... BlockCounts>
+requires (
+	ValidStrideRange<StrideStep, StrideMin, StrideMax> &&
+	sizeof...(BlockCounts) == (StrideMax - StrideMin) / StrideStep + 1 &&
+	((BlockCounts >= MetapoolConstraints::min_last_block_count) && ...)
+)
+struct ExplicitMetapoolConfig : StrideRangeConfig<StrideStep, StrideMin, StrideMax>
+{
+	static constexpr std::array<uint32_t, sizeof...(BlockCounts)> block_counts = {static_cast<uint32_t>(BlockCounts)...};
+
+	static constexpr uint32_t base_block_count = block_counts.front();
+};
+
+
+// block counts from a consteval callable taking the stride index, e.g. a captureless lambda
+
+template <auto Curve, auto StrideStep, auto StrideMin, auto StrideMax>
+concept ValidCapacityCurve =
+	ValidStrideRange<StrideStep, StrideMin, StrideMax> &&
+	std::is_invocable_r_v<uint32_t, decltype(Curve), uint32_t> &&
+	[]() consteval {
+		for (uint32_t i = 0; i <= (StrideMax - StrideMin) / StrideStep; ++i) {
+			if (static_cast<uint32_t>(Curve(i)) < MetapoolConstraints::min_last_block_count)
+				return false;
+		}
+		return true;
+	}();
+
+template <auto Curve, auto StrideStep, auto StrideMin, auto StrideMax>
+requires ValidCapacityCurve<Curve, StrideStep, StrideMin, StrideMax>
+struct CurveMetapoolConfig : StrideRangeConfig<StrideStep, StrideMin, StrideMax>
+{
+	using range_type = StrideRangeConfig<StrideStep, StrideMin, StrideMax>;
+
+	static constexpr auto block_counts = []() consteval {
+		std::array<uint32_t, range_type::stride_count> counts {};
+
+		for (uint32_t i = 0; i < range_type::stride_count; ++i)
+			counts[i] = static_cast<uint32_t>(Curve(i));
+
+		return counts;
+	}();
+
+	static constexpr uint32_t base_block_count = block_counts.front();
+};
+
+
+// overrides the per-thread magazine size of every stride in a metapool, 0 bypasses magazines
+
+template <uint32_t MagazineSize, IsMetapoolConfig Config>
+requires (MagazineSize <= MetapoolConstraints::max_magazine_size)
+struct MagazineConfig : Config
+{
+	static constexpr uint32_t magazine_size = MagazineSize;
 };
 
 } // mtp::cfg
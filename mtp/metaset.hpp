@@ -5,7 +5,10 @@
 #include <array>
 #include <algorithm>
 
+#include "page_map.hpp"
+#include "set_options.hpp"
 #include "allocator_config.hpp"
+#include "size_class_table.hpp"
 
 #include "math.hpp"
 #include "fail.hpp"
@@ -33,7 +36,7 @@ namespace mtp::cfg {
 namespace mtp::core {
 
 
-	template <typename... Metapools>
+	template <mtp::cfg::SetOptions Options, typename... Metapools>
 	class Metaset final
 	{
 	public:
@@ -42,6 +45,10 @@ namespace mtp::core {
 
 		static constexpr size_t set_size = sizeof...(Metapools);
 
+		static constexpr mtp::cfg::SetOptions options = Options;
+
+		static constexpr bool header_free = Options.block_header == mtp::cfg::BlockHeader::page_map;
+
 	private:
 
 		template <size_t... Is>
@@ -111,6 +118,51 @@ namespace mtp::core {
 		}
 
 
+		template <typename Tuple>
+		static consteval auto build_proxy_block_counts()
+		{
+			constexpr size_t total_stride_count = [] {
+				size_t sum = 0;
+				for (const auto& range : range_metadata_array)
+					sum += range.stride_count;
+				return sum;
+			}();
+
+			std::array<uint32_t, total_stride_count> block_counts {};
+
+			[&block_counts]<size_t... Is>(std::index_sequence<Is...>) consteval {
+				(..., [&block_counts]<size_t Index>() consteval {
+					using Mpool = std::tuple_element_t<sorted_indices[Index], Tuple>;
+					const uint16_t proxy_base = range_metadata_array[Index].base_proxy_index;
+
+					for (uint32_t i = 0; i < Mpool::MetapoolTraits::stride_count; ++i)
+						block_counts[proxy_base + i] = Mpool::MetapoolTraits::block_counts[i];
+				}.template operator()<Is>());
+			}(std::make_index_sequence<set_size>{});
+
+			return block_counts;
+		}
+
+
+		template <typename Tuple>
+		static consteval auto build_proxy_magazine_sizes()
+		{
+			std::array<uint32_t, proxy_block_counts.size()> magazine_sizes {};
+
+			[&magazine_sizes]<size_t... Is>(std::index_sequence<Is...>) consteval {
+				(..., [&magazine_sizes]<size_t Index>() consteval {
+					using Mpool = std::tuple_element_t<sorted_indices[Index], Tuple>;
+					const uint16_t proxy_base = range_metadata_array[Index].base_proxy_index;
+
+					for (uint32_t i = 0; i < Mpool::MetapoolTraits::stride_count; ++i)
+						magazine_sizes[proxy_base + i] = Mpool::MetapoolTraits::magazine_sizes[i];
+				}.template operator()<Is>());
+			}(std::make_index_sequence<set_size>{});
+
+			return magazine_sizes;
+		}
+
+
 		template <size_t Index>
 		static constexpr uint32_t get_min_stride()
 		{
@@ -210,20 +262,43 @@ namespace mtp::core {
 
 		static constexpr auto range_metadata_array = build_range_array<TupleType>();
 
-		static constexpr size_t arena_size =
+		static constexpr auto size_class_table = mtp::cfg::build_size_class_table<range_metadata_array>();
+
+		static constexpr auto proxy_block_counts = build_proxy_block_counts<TupleType>();
+
+		static constexpr auto proxy_magazine_sizes = build_proxy_magazine_sizes<TupleType>();
+
+		static constexpr size_t pool_bytes =
 			([]<size_t... Is>(std::index_sequence<Is...>) constexpr {
 				return (0 + ... + std::tuple_element_t<Is, TupleType>::MetapoolTraits::reserved_bytes);
 			})(std::make_index_sequence<set_size>{});
 
+		static constexpr size_t page_map_bytes = header_free ? PageMap::table_bytes_for(pool_bytes) : 0;
+
+		static constexpr bool packed = Options.pack_stride_limit != 0;
+
+		// pool_bytes keeps the full reservation of packed strides, the primary ranges only shrink into it
+
+		static constexpr size_t pack_region_bytes =
+			([]<size_t... Is>(std::index_sequence<Is...>) constexpr {
+				return (0 + ... + std::tuple_element_t<Is, TupleType>::MetapoolTraits::packed_bytes(
+					Options.pack_stride_limit,
+					Options.pack_bytes
+				));
+			})(std::make_index_sequence<set_size>{});
+
+		static constexpr size_t arena_size = page_map_bytes + pack_region_bytes + pool_bytes;
+
 		static_assert(arena_size <= mtp::cfg::max_arena_size,
 			SET_ARENA_TOO_LARGE_MSG);
 
-		using AllocatorConfigType = mtp::cfg::AllocatorConfig<range_metadata_array>;
+		using AllocatorConfigType =
+			mtp::cfg::AllocatorConfig<range_metadata_array, size_class_table, proxy_block_counts, sorted_index_map, Options>;
 
 
 		static constexpr auto create_allocator_config()
 		{
-			return mtp::cfg::AllocatorConfig<range_metadata_array>();
+			return AllocatorConfigType();
 		}
 
 		static_assert(
@@ -245,8 +320,25 @@ namespace mtp {
 	template <capf Fn, auto Base, auto Step, auto... Pivots>
 	using def = core::Metapool<cfg::MetapoolConfig<Fn, Base, Step, Pivots...>>;
 
+	template <auto Step, auto StrideMin, auto StrideMax, auto... BlockCounts>
+	using def_explicit = core::Metapool<cfg::ExplicitMetapoolConfig<Step, StrideMin, StrideMax, BlockCounts...>>;
+
+	template <auto Curve, auto Step, auto StrideMin, auto StrideMax>
+	using def_curve = core::Metapool<cfg::CurveMetapoolConfig<Curve, Step, StrideMin, StrideMax>>;
+
+	template <uint32_t Size, typename Def>
+	using magazine = core::Metapool<cfg::MagazineConfig<Size, typename Def::config_type>>;
+
+	using set_options = cfg::SetOptions;
+	using header      = cfg::BlockHeader;
+	using commit      = cfg::CommitPolicy;
+	using huge_pages  = cfg::HugePages;
+
 	template <typename... Metapools>
-	using metaset = core::Metaset<Metapools...>;
+	using metaset = core::Metaset<cfg::SetOptions{}, Metapools...>;
+
+	template <cfg::SetOptions Options, typename... Metapools>
+	using metaset_with = core::Metaset<Options, Metapools...>;
 
 } // mtp
 
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+
+#include "metaset.hpp"
+#include "metapool.hpp"
+#include "set_options.hpp"
+#include "metapool_config.hpp"
+
+#include "fail.hpp"
+
+
+namespace mtp::cfg {
+
+
+// a type with the number of blocks expected live at once, bare types get default_type_block_count
+
+template <typename T, uint32_t Count>
+requires (Count >= MetapoolConstraints::min_base_block_count)
+struct ExpectedCount
+{
+	using type = T;
+
+	static constexpr uint32_t count = Count;
+};
+
+template <typename T>
+struct TypeEntry
+{
+	using type = T;
+
+	static constexpr uint32_t count = MetapoolConstraints::default_type_block_count;
+};
+
+template <typename T, uint32_t Count>
+struct TypeEntry<ExpectedCount<T, Count>>
+{
+	using type = T;
+
+	static constexpr uint32_t count = Count;
+};
+
+
+// every type gets a stride of exactly sizeof + header rounded to its alignment, types sharing a stride add
+// their counts. consecutive strides merge into one metapool when they are evenly spaced by a power of two,
+// with a capacity function when one reproduces their counts and explicit counts otherwise,
+// so no stride is rounded and no block count is padded
+
+template <SetOptions Options, typename... Ts>
+struct TypeSetPlan
+{
+	static constexpr size_t type_count = sizeof...(Ts);
+
+	static_assert(type_count > 0,
+		TYPESET_EMPTY_MSG);
+
+	struct Stride
+	{
+		uint32_t stride {0};
+		uint32_t count  {0};
+	};
+
+	struct Def
+	{
+		CapacityFunction fn   {CapacityFunction::flat};
+		uint32_t         base {0};
+		uint32_t         step {0};
+
+		size_t pivot_count {0};
+		std::array<uint32_t, type_count + 1> pivots {};
+
+		// explicit_counts: pivots hold stride_min and stride_max, counts one entry per stride
+
+		bool   explicit_counts {false};
+		size_t stride_count    {0};
+		std::array<uint32_t, type_count> counts {};
+	};
+
+	static constexpr uint32_t header_bytes =
+		Options.block_header == BlockHeader::page_map ? 0U : static_cast<uint32_t>(sizeof(uint16_t));
+
+	template <typename T>
+	static consteval uint64_t stride_of()
+	{
+		const uint64_t align_to = std::max<uint64_t>(MetapoolConstraints::min_stride_step, alignof(T));
+
+		return (sizeof(T) + header_bytes + align_to - 1U) & ~(align_to - 1U);
+	}
+
+	static_assert(((stride_of<typename TypeEntry<Ts>::type>() <= MetapoolConstraints::max_stride) && ...),
+		TYPESET_TYPE_TOO_LARGE_MSG);
+
+	static consteval auto collect()
+	{
+		std::array<Stride, type_count> entries {
+			Stride {static_cast<uint32_t>(stride_of<typename TypeEntry<Ts>::type>()), TypeEntry<Ts>::count}...
+		};
+
+		std::sort(entries.begin(), entries.end(), [](const Stride& a, const Stride& b) { return a.stride < b.stride; });
+
+		std::array<Stride, type_count> merged {};
+		size_t size = 0;
+
+		for (const Stride& entry : entries) {
+			if (size != 0 && merged[size - 1].stride == entry.stride)
+				merged[size - 1].count += entry.count;
+			else
+				merged[size++] = entry;
+		}
+
+		return std::pair {merged, size};
+	}
+
+	static constexpr auto collected    = collect();
+	static constexpr auto strides      = collected.first;
+	static constexpr size_t stride_count = collected.second;
+
+	static consteval uint64_t next_count(CapacityFunction fn, uint64_t count)
+	{
+		switch (fn) {
+			case CapacityFunction::div8: return std::max<uint64_t>(count / 8U, MetapoolConstraints::min_last_block_count);
+			case CapacityFunction::div4: return std::max<uint64_t>(count / 4U, MetapoolConstraints::min_last_block_count);
+			case CapacityFunction::div2: return std::max<uint64_t>(count / 2U, MetapoolConstraints::min_last_block_count);
+			case CapacityFunction::flat: return count;
+			case CapacityFunction::mul2: return count * 2U;
+			case CapacityFunction::mul4: return count * 4U;
+			case CapacityFunction::mul8: return count * 8U;
+		}
+
+		return count;
+	}
+
+	// strides [first, last] as one metapool with exact counts, pivot_count 0 when they cannot share one
+
+	static consteval Def fit(size_t first, size_t last)
+	{
+		Def def;
+
+		if (first == last) {
+			def.base        = strides[first].count;
+			def.step        = MetapoolConstraints::min_stride_step;
+			def.pivot_count = 2;
+			def.pivots[0]   = strides[first].stride;
+			def.pivots[1]   = strides[first].stride;
+			return def;
+		}
+
+		const uint32_t step = strides[first + 1].stride - strides[first].stride;
+
+		if ((step & (step - 1U)) != 0U || step > MetapoolConstraints::max_stride_step || strides[first].stride % step != 0U)
+			return def;
+
+		for (size_t i = first + 1; i <= last; ++i) {
+			if (strides[i].stride - strides[i - 1].stride != step)
+				return def;
+		}
+
+		constexpr std::array<CapacityFunction, 7> functions {
+			CapacityFunction::flat,
+			CapacityFunction::div2, CapacityFunction::div4, CapacityFunction::div8,
+			CapacityFunction::mul2, CapacityFunction::mul4, CapacityFunction::mul8
+		};
+
+		// a pivot applies the function once, the last stride is always a pivot
+
+		for (CapacityFunction fn : functions) {
+			Def candidate;
+
+			candidate.fn        = fn;
+			candidate.base      = strides[first].count;
+			candidate.step      = step;
+			candidate.pivots[0] = strides[first].stride;
+
+			size_t   pivots = 1;
+			uint64_t count  = candidate.base;
+			bool     exact  = true;
+
+			for (size_t i = first + 1; i <= last && exact; ++i) {
+				if (i != last && strides[i].count == count)
+					continue;
+
+				count = next_count(fn, count);
+				exact = count == strides[i].count;
+
+				candidate.pivots[pivots++] = strides[i].stride;
+			}
+
+			if (exact) {
+				candidate.pivot_count = pivots;
+				return candidate;
+			}
+		}
+
+		def.explicit_counts = true;
+		def.base            = strides[first].count;
+		def.step            = step;
+		def.pivot_count     = 2;
+		def.pivots[0]       = strides[first].stride;
+		def.pivots[1]       = strides[last].stride;
+		def.stride_count    = last - first + 1;
+
+		for (size_t i = first; i <= last; ++i)
+			def.counts[i - first] = strides[i].count;
+
+		return def;
+	}
+
+	// fewest metapools covering every stride
+
+	static consteval auto plan()
+	{
+		std::array<size_t, type_count + 1> best {};
+		std::array<size_t, type_count + 1> from {};
+
+		for (size_t end = 1; end <= stride_count; ++end) {
+			best[end] = type_count + 1;
+
+			for (size_t begin = 0; begin < end; ++begin) {
+				if (best[begin] + 1 < best[end] && fit(begin, end - 1).pivot_count != 0) {
+					best[end] = best[begin] + 1;
+					from[end] = begin;
+				}
+			}
+		}
+
+		std::array<Def, type_count> defs {};
+		size_t count = best[stride_count];
+
+		for (size_t end = stride_count, index = count; index > 0; --index) {
+			defs[index - 1] = fit(from[end], end - 1);
+			end = from[end];
+		}
+
+		return std::pair {defs, count};
+	}
+
+	static constexpr auto planned   = plan();
+	static constexpr auto defs      = planned.first;
+	static constexpr size_t def_count = planned.second;
+};
+
+
+template <
+	typename Plan,
+	size_t   Index,
+	typename = std::make_index_sequence<Plan::defs[Index].explicit_counts ? 0 : Plan::defs[Index].pivot_count>,
+	typename = std::make_index_sequence<Plan::defs[Index].explicit_counts ? Plan::defs[Index].stride_count : 0>
+>
+struct PlannedMetapool;
+
+template <typename Plan, size_t Index, size_t... Ps>
+struct PlannedMetapool<Plan, Index, std::index_sequence<Ps...>, std::index_sequence<>>
+{
+	using type = mtp::core::Metapool<MetapoolConfig<
+		Plan::defs[Index].fn,
+		Plan::defs[Index].base,
+		Plan::defs[Index].step,
+		Plan::defs[Index].pivots[Ps]...
+	>>;
+};
+
+template <typename Plan, size_t Index, size_t... Cs>
+struct PlannedMetapool<Plan, Index, std::index_sequence<>, std::index_sequence<Cs...>>
+{
+	using type = mtp::core::Metapool<ExplicitMetapoolConfig<
+		Plan::defs[Index].step,
+		Plan::defs[Index].pivots[0],
+		Plan::defs[Index].pivots[1],
+		Plan::defs[Index].counts[Cs]...
+	>>;
+};
+
+template <SetOptions Options, typename Plan, typename = std::make_index_sequence<Plan::def_count>>
+struct PlannedMetaset;
+
+template <SetOptions Options, typename Plan, size_t... Is>
+struct PlannedMetaset<Options, Plan, std::index_sequence<Is...>>
+{
+	using type = mtp::core::Metaset<Options, typename PlannedMetapool<Plan, Is>::type...>;
+};
+
+} // mtp::cfg
+
+
+namespace mtp {
+
+
+	template <typename T, uint32_t Count>
+	using expect = cfg::ExpectedCount<T, Count>;
+
+	template <typename... Ts>
+	using metaset_for = typename cfg::PlannedMetaset<cfg::SetOptions{}, cfg::TypeSetPlan<cfg::SetOptions{}, Ts...>>::type;
+
+	template <cfg::SetOptions Options, typename... Ts>
+	using metaset_for_with = typename cfg::PlannedMetaset<Options, cfg::TypeSetPlan<Options, Ts...>>::type;
+
+} // mtp
@@ -3,7 +3,14 @@
 #include "mtpint.hpp"
 
 #include <memory>
+#include <thread>
+#include <vector>
 #include <cstdlib>
+#include <algorithm>
+
+#include <sys/mman.h>
+
+#include "set_options.hpp"
 
 #include "fail.hpp"
 
@@ -15,21 +22,51 @@ class MonotonicArena final
 {
 public:
 
-	MonotonicArena(size_t size, size_t alignment)
+	MonotonicArena(
+		size_t                 size,
+		size_t                 alignment,
+		mtp::cfg::CommitPolicy commit           = mtp::cfg::CommitPolicy::reserve,
+		uint32_t               prefault_threads = 0,
+		mtp::cfg::HugePages    huge_pages       = mtp::cfg::HugePages::none
+	)
 		: m_size {size}
 	{
-		size_t padded_size = ((size + alignment - 1) / alignment) * alignment;
+		if (huge_pages != mtp::cfg::HugePages::none)
+			alignment = std::max(alignment, huge_page_size);
+
+		m_mapped_size = ((size + alignment - 1) / alignment) * alignment;
+
+		if (huge_pages == mtp::cfg::HugePages::explicit_tlb)
+			m_arena = map_hugetlb(m_mapped_size, commit);
+
+		if (!m_arena && huge_pages != mtp::cfg::HugePages::none)
+			m_arena = map_transparent(m_mapped_size, commit);
 
-		m_arena = static_cast<std::byte*>(std::aligned_alloc(alignment, padded_size));
+		if (!m_arena)
+			m_arena = map(m_mapped_size, commit);
 
 		if (!m_arena) {
 			mtp::err::fatal(mtp::err::arena_alloc_failed);
 		}
+
+		MTP_ASSERT(reinterpret_cast<std::uintptr_t>(m_arena) % alignment == 0,
+			mtp::err::arena_base_misaligned);
+
+		if (commit == mtp::cfg::CommitPolicy::prefault)
+			prefault(prefault_threads);
 	}
 
+	// non-owning view over a range fetched from another arena
+
+	MonotonicArena(std::byte* memory, size_t size) noexcept
+		: m_arena {memory}
+		, m_size  {size}
+	{}
+
 	~MonotonicArena()
 	{
-		std::free(m_arena);
+		if (m_arena && m_mapped_size != 0)
+			::munmap(m_arena, m_mapped_size);
 	}
 
 	MonotonicArena(const MonotonicArena&) = delete;
@@ -70,6 +107,18 @@ public:
 	}
 
 
+	[[nodiscard]] inline std::byte* base() const noexcept
+	{
+		return m_arena;
+	}
+
+
+	[[nodiscard]] inline size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+
 	inline bool is_equal(const MonotonicArena& other) const noexcept
 	{
 		return this == &other;
@@ -83,9 +132,142 @@ public:
 
 private:
 
-	std::byte* m_arena {nullptr};
-	size_t m_size      {0};
-	size_t m_offset    {0};
+	static inline std::byte* map(size_t size, mtp::cfg::CommitPolicy commit) noexcept
+	{
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#if defined(MAP_NORESERVE)
+		if (commit != mtp::cfg::CommitPolicy::populate)
+			flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_POPULATE)
+		if (commit == mtp::cfg::CommitPolicy::populate)
+			flags |= MAP_POPULATE;
+#endif
+
+		void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+		if (memory == MAP_FAILED) [[unlikely]]
+			return nullptr;
+
+#if !defined(MAP_POPULATE)
+		if (commit == mtp::cfg::CommitPolicy::populate)
+			touch(static_cast<std::byte*>(memory), static_cast<std::byte*>(memory) + size);
+#endif
+
+		return static_cast<std::byte*>(memory);
+	}
+
+	// never MAP_NORESERVE here: an unreserved hugetlb mapping raises SIGBUS on first touch once the pool
+	// runs dry, a reserved one fails up front and lets the caller fall back
+
+	static inline std::byte* map_hugetlb(size_t size, mtp::cfg::CommitPolicy commit) noexcept
+	{
+#if defined(MAP_HUGETLB)
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+#if defined(MAP_POPULATE)
+		if (commit == mtp::cfg::CommitPolicy::populate)
+			flags |= MAP_POPULATE;
+#else
+		(void) commit;
+#endif
+
+		void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+		return memory == MAP_FAILED ? nullptr : static_cast<std::byte*>(memory);
+#else
+		(void) size;
+		(void) commit;
+		return nullptr;
+#endif
+	}
+
+	// over-reserves by one huge page, trims the mapping to a 2 MiB boundary and advises the kernel to back it
+	// with huge pages; an eager commit happens after the advice so it faults in huge pages, not 4 KiB ones
+
+	static inline std::byte* map_transparent(size_t size, mtp::cfg::CommitPolicy commit) noexcept
+	{
+#if defined(MADV_HUGEPAGE)
+		std::byte* reserved = map(size + huge_page_size, mtp::cfg::CommitPolicy::reserve);
+
+		if (!reserved) [[unlikely]]
+			return nullptr;
+
+		const auto address = reinterpret_cast<std::uintptr_t>(reserved);
+		const size_t head  = ((address + huge_page_size - 1) & ~(huge_page_size - 1)) - address;
+
+		std::byte* memory = reserved + head;
+
+		if (head != 0)
+			::munmap(reserved, head);
+
+		::munmap(memory + size, huge_page_size - head);
+
+		::madvise(memory, size, MADV_HUGEPAGE);
+
+		if (commit == mtp::cfg::CommitPolicy::populate)
+			touch(memory, memory + size);
+
+		return memory;
+#else
+		(void) size;
+		(void) commit;
+		return nullptr;
+#endif
+	}
+
+	// splits the mapping into page-aligned slices and writes one byte per page from each worker;
+	// when a worker cannot be started the calling thread touches every slice no worker took
+
+	inline void prefault(uint32_t thread_count) noexcept
+	{
+		const size_t page_count = m_mapped_size / page_size;
+
+		if (thread_count == 0)
+			thread_count = std::max(1U, std::thread::hardware_concurrency());
+
+		const size_t worker_count = std::min<size_t>(thread_count, std::max<size_t>(page_count, 1));
+		const size_t slice_pages  = (page_count + worker_count - 1) / worker_count;
+
+		auto slice_begin = [&](size_t slice) { return m_arena + std::min(slice * slice_pages, page_count) * page_size; };
+
+		std::vector<std::thread> workers;
+		size_t spawned = 1;
+
+		try {
+			workers.reserve(worker_count - 1);
+
+			for (; spawned < worker_count; ++spawned) {
+				std::byte* first = slice_begin(spawned);
+				std::byte* last  = slice_begin(spawned + 1);
+
+				workers.emplace_back([first, last] { touch(first, last); });
+			}
+		}
+		catch (...) {
+		}
+
+		touch(slice_begin(spawned), slice_begin(worker_count));
+		touch(m_arena, slice_begin(1));
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	static inline void touch(std::byte* first, std::byte* last) noexcept
+	{
+		for (volatile std::byte* page = first; page < last; page += page_size)
+			*page = std::byte{0};
+	}
+
+	static constexpr size_t page_size      = 4096U;
+	static constexpr size_t huge_page_size = 2ULL << 20;
+
+	std::byte* m_arena       {nullptr};
+	size_t     m_size        {0};
+	size_t     m_mapped_size {0};
+	size_t     m_offset      {0};
 };
 
 } // mtp::core
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include <sys/mman.h>
+
+#include "metapool_config.hpp"
+#include "owner_registry.hpp"
+
+
+namespace mtp::core {
+
+
+// mmap-backed chain of segments for elastic sets
+// segments are mapped on demand and kept across reset, so a rewound arena reuses them before mapping more
+// the chain is published with release stores and only unmapped with the arena, so any thread may test ownership
+
+class OverflowArena final
+{
+public:
+
+	explicit OverflowArena(size_t segment_size)
+		: m_segment_size {segment_size}
+	{}
+
+	~OverflowArena()
+	{
+		Segment* segment = m_first.load(std::memory_order_relaxed);
+
+		while (segment != nullptr) {
+			Segment* next = segment->next.load(std::memory_order_relaxed);
+			::munmap(segment, segment->size);
+			segment = next;
+		}
+	}
+
+	OverflowArena(const OverflowArena&) = delete;
+	OverflowArena& operator=(const OverflowArena&) = delete;
+	OverflowArena(OverflowArena&&) = delete;
+	OverflowArena& operator=(OverflowArena&&) = delete;
+
+public:
+
+	[[nodiscard]] inline std::byte* fetch(size_t alloc_size, size_t alignment, size_t shift) noexcept
+	{
+		if (alloc_size == 0) [[unlikely]]
+			return nullptr;
+
+		if (m_current != nullptr) {
+			if (std::byte* block = carve(m_current, alloc_size, alignment, shift))
+				return block;
+
+			// rewound segments are reused in order before anything new is mapped
+
+			while (Segment* next = m_current->next.load(std::memory_order_relaxed)) {
+				m_current = next;
+				m_offset  = sizeof(Segment);
+
+				if (std::byte* block = carve(m_current, alloc_size, alignment, shift))
+					return block;
+			}
+		}
+
+		Segment* segment = map_segment(alloc_size + alignment + shift);
+
+		if (segment == nullptr) [[unlikely]]
+			return nullptr;
+
+		m_current = segment;
+		m_offset  = sizeof(Segment);
+
+		return carve(m_current, alloc_size, alignment, shift);
+	}
+
+	inline void reset() noexcept
+	{
+		m_current = m_first.load(std::memory_order_relaxed);
+		m_offset  = sizeof(Segment);
+	}
+
+	// walks the segment chain, safe from any thread while the arena is alive
+
+	[[nodiscard]] inline bool owns(const std::byte* block) const noexcept
+	{
+		for (const Segment* segment = m_first.load(std::memory_order_acquire); segment != nullptr;
+			segment = segment->next.load(std::memory_order_acquire)) {
+			const auto* begin = reinterpret_cast<const std::byte*>(segment);
+
+			if (block >= begin && block < begin + segment->size)
+				return true;
+		}
+
+		return false;
+	}
+
+	// registers every segment, mapped so far and from now on, with the owner registry under the given owner;
+	// nullptr stops registering, the owner removes what it registered itself
+
+	inline void bind(void* owner)
+	{
+		m_owner = owner;
+
+		if (owner == nullptr)
+			return;
+
+		for (Segment* segment = m_first.load(std::memory_order_relaxed); segment != nullptr;
+			segment = segment->next.load(std::memory_order_relaxed)) {
+			OwnerRegistry::insert(reinterpret_cast<const std::byte*>(segment), segment->size, owner);
+		}
+	}
+
+	[[nodiscard]] inline size_t mapped_bytes() const noexcept
+	{
+		return m_mapped_bytes;
+	}
+
+private:
+
+	struct Segment
+	{
+		std::atomic<Segment*> next {nullptr};
+		size_t                size {0};
+	};
+
+	inline std::byte* carve(Segment* segment, size_t alloc_size, size_t alignment, size_t shift) noexcept
+	{
+		if (m_offset + shift > segment->size)
+			return nullptr;
+
+		std::byte* segment_base = reinterpret_cast<std::byte*>(segment);
+
+		void* aligned_ptr = segment_base + m_offset + shift;
+		size_t available  = segment->size - m_offset - shift;
+
+		if (std::align(alignment, alloc_size, aligned_ptr, available) == nullptr)
+			return nullptr;
+
+		std::byte* base_ptr = static_cast<std::byte*>(aligned_ptr);
+
+		m_offset = static_cast<size_t>(base_ptr - segment_base) + alloc_size;
+
+		return base_ptr;
+	}
+
+	inline Segment* map_segment(size_t min_size) noexcept
+	{
+		const size_t page = mtp::cfg::MetapoolConstraints::freelist_alignment;
+		const size_t wanted = std::max(m_segment_size, min_size + sizeof(Segment));
+		const size_t size = (wanted + page - 1) & ~(page - 1);
+
+		void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (memory == MAP_FAILED) [[unlikely]]
+			return nullptr;
+
+		auto* segment = new (memory) Segment {nullptr, size};
+
+		if (m_last != nullptr)
+			m_last->next.store(segment, std::memory_order_release);
+		else
+			m_first.store(segment, std::memory_order_release);
+
+		m_last = segment;
+		m_mapped_bytes += size;
+
+		if (m_owner != nullptr)
+			OwnerRegistry::insert(static_cast<const std::byte*>(memory), size, m_owner);
+
+		return segment;
+	}
+
+	size_t m_segment_size {0};
+	size_t m_offset       {0};
+	size_t m_mapped_bytes {0};
+
+	std::atomic<Segment*> m_first {nullptr};
+
+	Segment* m_last    {nullptr};
+	Segment* m_current {nullptr};
+
+	void* m_owner {nullptr};
+};
+
+} // mtp::core
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <array>
+#include <mutex>
+#include <atomic>
+
+#include "fail.hpp"
+
+
+namespace mtp::core {
+
+
+// process-wide map from the address ranges of live TLS arenas and their overflow segments to their owner
+// ranges never overlap and are kept sorted by begin, so a lookup is one binary search whatever the thread count
+// writers (enroll, withdraw, a newly mapped segment) are rare and serialized; readers never block them and
+// retry when the sequence shows a write overlapped their search
+
+class OwnerRegistry final
+{
+public:
+
+	static constexpr size_t max_ranges = 4096U;
+
+	OwnerRegistry() = delete;
+
+	static inline void insert(const std::byte* begin, size_t size, void* owner)
+	{
+		std::lock_guard lock {s_mutex};
+
+		const size_t count = s_count.load(std::memory_order_relaxed);
+
+		if (count == max_ranges) [[unlikely]]
+			mtp::err::fatal(mtp::err::remote_owners_full);
+
+		const auto address = reinterpret_cast<std::uintptr_t>(begin);
+		const size_t position = upper_bound(address, count);
+
+		begin_write();
+
+		for (size_t i = count; i > position; --i)
+			copy(s_ranges[i], s_ranges[i - 1]);
+
+		s_ranges[position].begin.store(address, std::memory_order_relaxed);
+		s_ranges[position].end.store(address + size, std::memory_order_relaxed);
+		s_ranges[position].owner.store(owner, std::memory_order_relaxed);
+
+		s_count.store(count + 1, std::memory_order_relaxed);
+
+		end_write();
+	}
+
+	// drops every range of the owner
+
+	static inline void remove(void* owner) noexcept
+	{
+		std::lock_guard lock {s_mutex};
+
+		const size_t count = s_count.load(std::memory_order_relaxed);
+
+		begin_write();
+
+		size_t kept = 0;
+
+		for (size_t i = 0; i < count; ++i) {
+			if (s_ranges[i].owner.load(std::memory_order_relaxed) == owner)
+				continue;
+
+			if (kept != i)
+				copy(s_ranges[kept], s_ranges[i]);
+
+			++kept;
+		}
+
+		s_count.store(kept, std::memory_order_relaxed);
+
+		end_write();
+	}
+
+	// owner of the range containing the block, nullptr when no live range does
+
+	[[nodiscard]] static inline void* find(const std::byte* block) noexcept
+	{
+		const auto address = reinterpret_cast<std::uintptr_t>(block);
+
+		while (true) {
+			const uint64_t sequence = s_sequence.load(std::memory_order_acquire);
+
+			if ((sequence & 1U) != 0) [[unlikely]]
+				continue;
+
+			const size_t position = upper_bound(address, s_count.load(std::memory_order_relaxed));
+
+			void* owner = nullptr;
+
+			if (position > 0) {
+				const Range& range = s_ranges[position - 1];
+
+				if (address < range.end.load(std::memory_order_relaxed))
+					owner = range.owner.load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (s_sequence.load(std::memory_order_relaxed) == sequence) [[likely]]
+				return owner;
+		}
+	}
+
+private:
+
+	// atomics value-initialize, the in-class initializers gcc would reject for a nested aggregate are not needed
+
+	struct Range
+	{
+		std::atomic<std::uintptr_t> begin;
+		std::atomic<std::uintptr_t> end;
+		std::atomic<void*>          owner;
+	};
+
+	// first range starting after the address; a torn read during a write only yields a result that is discarded
+
+	[[nodiscard]] static inline size_t upper_bound(std::uintptr_t address, size_t count) noexcept
+	{
+		size_t low  = 0;
+		size_t high = count < max_ranges ? count : max_ranges;
+
+		while (low < high) {
+			const size_t middle = low + (high - low) / 2;
+
+			if (s_ranges[middle].begin.load(std::memory_order_relaxed) <= address)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		return low;
+	}
+
+	static inline void copy(Range& target, const Range& source) noexcept
+	{
+		target.begin.store(source.begin.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		target.end.store(source.end.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		target.owner.store(source.owner.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	static inline void begin_write() noexcept
+	{
+		s_sequence.store(s_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	static inline void end_write() noexcept
+	{
+		s_sequence.store(s_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	inline static std::mutex s_mutex;
+
+	inline static std::atomic<uint64_t> s_sequence {0};
+	inline static std::atomic<size_t>   s_count    {0};
+
+	inline static std::array<Range, max_ranges> s_ranges {};
+};
+
+} // mtp::core
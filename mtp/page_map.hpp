@@ -0,0 +1,88 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <bit>
+
+#include "metapool_config.hpp"
+
+#include "fail.hpp"
+
+
+namespace mtp::core {
+
+
+// side table for header-free sets: one proxy index per arena page
+// pools start on page boundaries and never share a page, so the page of a block identifies its stride
+
+class PageMap final
+{
+public:
+
+	using proxy_index_t = uint16_t;
+
+	static constexpr size_t page_size  = mtp::cfg::MetapoolConstraints::freelist_alignment;
+	static constexpr size_t page_shift = std::countr_zero(page_size);
+
+	static constexpr proxy_index_t invalid_proxy = 0xFFFF;
+
+	PageMap() = default;
+
+	PageMap(const std::byte* base, proxy_index_t* entries, size_t page_count)
+		: m_base       {base}
+		, m_entries    {entries}
+		, m_page_count {page_count}
+	{
+		MTP_ASSERT(entries != nullptr || page_count == 0,
+			mtp::err::page_map_entries_null);
+
+		for (size_t page = 0; page < m_page_count; ++page)
+			m_entries[page] = invalid_proxy;
+	}
+
+	inline void assign(const std::byte* begin, size_t size, proxy_index_t proxy_index) noexcept
+	{
+		const size_t first = page_of(begin);
+		const size_t last  = page_of(begin + size - 1);
+
+		MTP_ASSERT(begin >= m_base && last < m_page_count,
+			mtp::err::page_map_range_oob);
+
+		for (size_t page = first; page <= last; ++page)
+			m_entries[page] = proxy_index;
+	}
+
+	[[nodiscard]] inline proxy_index_t lookup(const std::byte* block) const noexcept
+	{
+		const size_t page = page_of(block);
+
+		MTP_ASSERT(block >= m_base && page < m_page_count,
+			mtp::err::page_map_range_oob);
+
+		return m_entries[page];
+	}
+
+	[[nodiscard]] static constexpr size_t pages_for(size_t bytes) noexcept
+	{
+		return (bytes + page_size - 1) >> page_shift;
+	}
+
+	[[nodiscard]] static constexpr size_t table_bytes_for(size_t bytes) noexcept
+	{
+		const size_t raw = pages_for(bytes) * sizeof(proxy_index_t);
+		return (raw + page_size - 1) & ~(page_size - 1);
+	}
+
+private:
+
+	[[nodiscard]] inline size_t page_of(const std::byte* ptr) const noexcept
+	{
+		return static_cast<size_t>(ptr - m_base) >> page_shift;
+	}
+
+	const std::byte* m_base       {nullptr};
+	proxy_index_t*   m_entries    {nullptr};
+	size_t           m_page_count {0};
+};
+
+} // mtp::core
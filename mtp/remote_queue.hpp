@@ -0,0 +1,121 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <new>
+#include <atomic>
+
+#include "freelist.hpp"
+#include "overflow_arena.hpp"
+#include "owner_registry.hpp"
+
+#include "fail.hpp"
+
+
+namespace mtp::core {
+
+
+// return path of one TLS arena: threads that free a block they do not own push it here,
+// the owner takes the whole stack with a single exchange on its next miss
+// producers only push and the consumer only detaches everything, so the stack needs no ABA tag
+// an elastic arena also owns its overflow segments, so blocks carved from them find their way home too
+
+template <typename Config>
+class RemoteQueue final
+{
+public:
+
+	RemoteQueue(const std::byte* begin, size_t size, OverflowArena* overflow = nullptr)
+		: m_begin    {begin}
+		, m_end      {begin + size}
+		, m_overflow {overflow}
+	{
+		enroll();
+	}
+
+	~RemoteQueue()
+	{
+		withdraw();
+	}
+
+	RemoteQueue(const RemoteQueue&) = delete;
+	RemoteQueue& operator=(const RemoteQueue&) = delete;
+
+	RemoteQueue(RemoteQueue&&) = delete;
+	RemoteQueue& operator=(RemoteQueue&&) = delete;
+
+public:
+
+	[[nodiscard]] inline bool owns(const std::byte* block) const noexcept
+	{
+		if (block >= m_begin && block < m_end) [[likely]]
+			return true;
+
+		if constexpr (Config::elastic)
+			return m_overflow != nullptr && m_overflow->owns(block);
+		else
+			return false;
+	}
+
+
+	inline void push(std::byte* block) noexcept
+	{
+		auto* node = reinterpret_cast<FreeBlock*>(block);
+
+		FreeBlock* top = m_top.load(std::memory_order_relaxed);
+
+		do {
+			node->next = top;
+		} while (!m_top.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+
+	[[nodiscard]] inline FreeBlock* take() noexcept
+	{
+		if (m_top.load(std::memory_order_relaxed) == nullptr) [[likely]]
+			return nullptr;
+
+		return m_top.exchange(nullptr, std::memory_order_acquire);
+	}
+
+	// a queue is enrolled while its arena has an owner, recycled arenas are withdrawn until adopted
+
+	inline void enroll()
+	{
+		OwnerRegistry::insert(m_begin, static_cast<size_t>(m_end - m_begin), this);
+
+		if constexpr (Config::elastic) {
+			if (m_overflow != nullptr)
+				m_overflow->bind(this);
+		}
+	}
+
+	inline void withdraw() noexcept
+	{
+		if constexpr (Config::elastic) {
+			if (m_overflow != nullptr)
+				m_overflow->bind(nullptr);
+		}
+
+		OwnerRegistry::remove(this);
+	}
+
+	// live queue whose arena or overflow segment contains the block, nullptr when the owner is gone
+
+	[[nodiscard]] static inline RemoteQueue* owner_of(const std::byte* block) noexcept
+	{
+		return static_cast<RemoteQueue*>(OwnerRegistry::find(block));
+	}
+
+private:
+
+	alignas(std::hardware_destructive_interference_size)
+	std::atomic<FreeBlock*> m_top {nullptr};
+
+	const std::byte* m_begin {nullptr};
+	const std::byte* m_end   {nullptr};
+
+	OverflowArena* m_overflow {nullptr};
+};
+
+} // mtp::core
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+
+namespace mtp::cfg {
+
+
+enum class BlockHeader
+{
+	inline_index,  // 2-byte proxy index stored in front of every block
+	page_map       // no per-block header, proxy index recovered from a per-page side table
+};
+
+
+enum class CommitPolicy
+{
+	reserve,   // virtual reservation only, pages are committed by first touch
+	populate,  // MAP_POPULATE, every page committed before the arena is handed out
+	prefault   // pages touched by worker threads before the arena is handed out
+};
+
+
+enum class HugePages
+{
+	none,         // 4 KiB pages
+	transparent,  // 2 MiB aligned mapping advised with MADV_HUGEPAGE
+	explicit_tlb  // MAP_HUGETLB from the reserved pool, transparent fallback when none are available
+};
+
+
+struct SetOptions
+{
+	BlockHeader block_header {BlockHeader::inline_index};
+
+	// elastic sets refill an exhausted stride with a chunk carved from an mmap-backed overflow arena
+
+	bool     elastic               {false};
+	uint32_t elastic_chunk_bytes   {256U * 1024U};
+	size_t   elastic_segment_bytes {64ULL << 20};
+
+	// arena commit policy, overridable per Shared instance; 0 prefault threads means hardware concurrency
+
+	CommitPolicy commit           {CommitPolicy::reserve};
+	uint32_t     prefault_threads {0};
+
+	HugePages huge_pages {HugePages::none};
+
+	// packing moves the first pack_bytes of every stride up to pack_stride_limit into one region at the
+	// front of the arena, so the hot end of each small freelist shares a page; 0 disables packing
+
+	uint32_t pack_stride_limit {0};
+	uint32_t pack_bytes        {4096};
+};
+
+} // mtp::cfg
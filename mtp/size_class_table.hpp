@@ -0,0 +1,157 @@
+#pragma once
+
+#include "mtpint.hpp"
+
+#include <array>
+#include <algorithm>
+
+
+namespace mtp::cfg {
+
+
+struct SizeClassConstraints
+{
+	static constexpr uint32_t small_limit   = 1024U;
+	static constexpr uint32_t quantum_shift = 3U;
+	static constexpr uint32_t small_shift   = 10U;
+	static constexpr uint32_t max_sub_bits  = 6U;
+	static constexpr uint32_t size_bits     = 32U;
+	static constexpr uint16_t invalid_proxy = 0xFFFF;
+
+	static_assert((1U << small_shift) == small_limit);
+	static_assert(small_shift >= max_sub_bits + quantum_shift);
+};
+
+
+// small table: aligned size / quantum -> proxy index (one load)
+// large table: (log2, top sub_bits of mantissa) -> first candidate range (one load + one compare)
+
+template <size_t SmallCount, size_t LargeCount>
+struct SizeClassTable
+{
+	uint32_t sub_bits    {0};
+	bool     large_exact {true};
+
+	std::array<uint16_t, SmallCount> small_proxy {};
+	std::array<uint16_t, LargeCount> large_range {};
+};
+
+
+namespace size_class {
+
+
+	template <typename Ranges>
+	constexpr uint32_t first_fit(const Ranges& ranges, uint64_t aligned)
+	{
+		const uint32_t range_count = static_cast<uint32_t>(ranges.size());
+
+		for (uint32_t mp_index = 0; mp_index < range_count; ++mp_index) {
+			const uint64_t mask   = ranges[mp_index].stride_step - 1U;
+			const uint64_t stride = (aligned + mask) & ~mask;
+
+			if (stride <= ranges[mp_index].stride_max)
+				return mp_index;
+		}
+
+		return range_count;
+	}
+
+	template <typename Ranges>
+	constexpr uint16_t proxy_for(const Ranges& ranges, uint32_t aligned)
+	{
+		const uint32_t mp_index = first_fit(ranges, aligned);
+
+		if (mp_index >= ranges.size())
+			return SizeClassConstraints::invalid_proxy;
+
+		const auto& range     = ranges[mp_index];
+		const uint32_t mask   = range.stride_step - 1U;
+		const uint32_t stride = (aligned + mask) & ~mask;
+		const uint32_t offset = stride >= range.stride_min ? stride - range.stride_min : 0U;
+
+		return static_cast<uint16_t>(range.base_proxy_index + (offset >> range.stride_shift));
+	}
+
+	constexpr uint32_t level_count()
+	{
+		return SizeClassConstraints::size_bits - SizeClassConstraints::small_shift;
+	}
+
+	constexpr uint64_t bucket_first(uint32_t level, uint32_t sub, uint32_t sub_bits)
+	{
+		const uint32_t log2 = level + SizeClassConstraints::small_shift;
+		return (uint64_t{1} << log2) + (uint64_t{sub} << (log2 - sub_bits)) + 1U;
+	}
+
+	constexpr uint64_t bucket_last(uint32_t level, uint32_t sub, uint32_t sub_bits)
+	{
+		const uint32_t log2 = level + SizeClassConstraints::small_shift;
+		return (uint64_t{1} << log2) + (uint64_t{sub + 1U} << (log2 - sub_bits));
+	}
+
+	template <typename Ranges>
+	constexpr uint32_t max_crossings(const Ranges& ranges, uint32_t sub_bits)
+	{
+		uint32_t crossings = 0;
+
+		for (uint32_t level = 0; level < level_count(); ++level) {
+			for (uint32_t sub = 0; sub < (1U << sub_bits); ++sub) {
+				const uint64_t first = bucket_first(level, sub, sub_bits);
+				const uint64_t last  = bucket_last(level, sub, sub_bits);
+
+				const uint32_t lo = first_fit(ranges, first);
+				const uint32_t hi = first_fit(ranges, last);
+
+				crossings = std::max(crossings, hi - lo);
+			}
+		}
+
+		return crossings;
+	}
+
+	template <typename Ranges>
+	constexpr uint32_t select_sub_bits(const Ranges& ranges)
+	{
+		for (uint32_t sub_bits = 0; sub_bits < SizeClassConstraints::max_sub_bits; ++sub_bits) {
+			if (max_crossings(ranges, sub_bits) <= 1U)
+				return sub_bits;
+		}
+
+		return SizeClassConstraints::max_sub_bits;
+	}
+
+} // size_class
+
+
+template <auto Ranges>
+consteval auto build_size_class_table()
+{
+	constexpr uint32_t sub_bits = size_class::select_sub_bits(Ranges);
+
+	constexpr size_t small_count = (SizeClassConstraints::small_limit >> SizeClassConstraints::quantum_shift) + 1U;
+	constexpr size_t large_count = static_cast<size_t>(size_class::level_count()) << sub_bits;
+
+	SizeClassTable<small_count, large_count> table {};
+
+	table.sub_bits    = sub_bits;
+	table.large_exact = size_class::max_crossings(Ranges, sub_bits) <= 1U;
+
+	for (uint32_t index = 0; index < small_count; ++index) {
+		table.small_proxy[index] = index == 0
+			? SizeClassConstraints::invalid_proxy
+			: size_class::proxy_for(Ranges, index << SizeClassConstraints::quantum_shift);
+	}
+
+	for (uint32_t level = 0; level < size_class::level_count(); ++level) {
+		for (uint32_t sub = 0; sub < (1U << sub_bits); ++sub) {
+			const uint64_t first = size_class::bucket_first(level, sub, sub_bits);
+
+			table.large_range[(level << sub_bits) | sub] =
+				static_cast<uint16_t>(size_class::first_fit(Ranges, first));
+		}
+	}
+
+	return table;
+}
+
+} // mtp::cfg
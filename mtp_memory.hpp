@@ -18,8 +18,12 @@
 #include <string_view>
 
 #include "mtp/metaset.hpp"
+#include "mtp/metaset_for.hpp"
 #include "mtp/metapool.hpp"
+#include "mtp/magazine.hpp"
+#include "mtp/frame_arena.hpp"
 #include "mtp/alloc_tracer.hpp"
+#include "mtp/alloc_recorder.hpp"
 #include "mtp/memory_model.hpp"
 
 
@@ -38,6 +42,23 @@ namespace mtp {
 template <typename Set>
 using shared = core::MemoryModel::Shared<Set, cfg::AllocatorTag::std_adapter>;
 
+template <typename Set>
+using shared_lock_free = core::MemoryModel::Shared<Set, cfg::AllocatorTag::std_adapter, cfg::SharedPolicy::lock_free>;
+
+template <typename Set>
+using magazine_cache = core::MagazineCache<Set>;
+
+
+using frame_options   = cfg::FrameOptions;
+using frame_buffering = cfg::FrameBuffering;
+using frame_marker    = core::FrameMarker;
+
+template <cfg::FrameOptions Options = cfg::FrameOptions{}>
+using frame_arena = core::FrameArena<Options>;
+
+template <cfg::FrameOptions Options = cfg::FrameOptions{}>
+using frame_arena_lock_free = core::FrameArena<Options, cfg::SharedPolicy::lock_free>;
+
 
 using default_set = metaset <
 
@@ -61,6 +82,26 @@ static inline void init_tls()
 }
 
 
+// hands the calling thread's arenas for the set back to the process-wide recycler before the thread exits
+// every block taken from them must already be freed, the next use on this thread adopts a recycled arena
+
+template <typename Set>
+static inline void release_tls()
+{
+	core::MemoryModel::release_thread_local<Set>();
+}
+
+
+// one frame arena per thread and options, mapped on first use and unmapped when the thread exits
+
+template <cfg::FrameOptions Options = cfg::FrameOptions{}>
+static inline auto& get_tls_frame()
+{
+	thread_local static frame_arena<Options> frame;
+	return frame;
+}
+
+
 struct as_ref_t { constexpr as_ref_t() noexcept = default; };
 struct as_ptr_t { constexpr as_ptr_t() noexcept = default; };
 
@@ -98,6 +139,51 @@ static inline void export_trace(std::string_view filename, bool clear = false)
 	cfg::AllocTracer::export_trace(filename, clear);
 }
 
+// time-series trace: open a frame stream, then mark each frame with the allocator whose pools to record
+
+static inline void trace_frames_open(std::string_view filename)
+{
+	cfg::AllocTracer::open_frames(filename);
+}
+
+template <typename Set>
+static inline void trace_frame_mark()
+{
+	if constexpr (cfg::AllocTracer::enabled)
+		cfg::AllocTracer::frame_mark(get_tls_allocator<Set>().stats());
+}
+
+template <typename Source>
+static inline void trace_frame_mark(const Source& source)
+{
+	if constexpr (cfg::AllocTracer::enabled)
+		cfg::AllocTracer::frame_mark(source.stats());
+}
+
+static inline void trace_frames_close()
+{
+	cfg::AllocTracer::close_frames();
+}
+
+// records one in every rate traced allocations and scales their counts, 1 traces everything
+
+static inline void set_trace_sampling(uint32_t rate)
+{
+	cfg::AllocTracer::set_sample_rate(rate);
+}
+
+// allocation log for replay: every alloc, free and reset between open and close, built with MTP_ENABLE_RECORD
+
+static inline void record_open(std::string_view filename)
+{
+	cfg::AllocRecorder::open(filename);
+}
+
+static inline void record_close()
+{
+	cfg::AllocRecorder::close();
+}
+
 
 #if defined(MTP_ENABLE_MTP_CONTAINERS)
 
@@ -133,6 +219,12 @@ inline auto make_vector(shared<Set>& shared, Types&&... args)
 	return cntr::make_vector<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_vector(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_vector<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_deque(Types&&... args)
 {
@@ -145,6 +237,12 @@ inline auto make_deque(shared<Set>& shared, Types&&... args)
 	return cntr::make_deque<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_deque(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_deque<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_list(Types&&... args)
 {
@@ -157,6 +255,12 @@ inline auto make_list(shared<Set>& shared, Types&&... args)
 	return cntr::make_list<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_list(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_list<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_forward_list(Types&&... args)
 {
@@ -169,6 +273,12 @@ inline auto make_forward_list(shared<Set>& shared, Types&&... args)
 	return cntr::make_forward_list<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_forward_list(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_forward_list<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_set(Types&&... args)
 {
@@ -181,6 +291,12 @@ inline auto make_set(shared<Set>& shared, Types&&... args)
 	return cntr::make_set<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_set(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_set<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_unordered_set(Types&&... args)
 {
@@ -193,6 +309,12 @@ inline auto make_unordered_set(shared<Set>& shared, Types&&... args)
 	return cntr::make_unordered_set<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unordered_set(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_unordered_set<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename K, typename V, typename Set, typename... Types>
 inline auto make_map(Types&&... args)
 {
@@ -205,6 +327,12 @@ inline auto make_map(shared<Set>& shared, Types&&... args)
 	return cntr::make_map<K, V, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename K, typename V, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_map(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_map<K, V>(frame, std::forward<Types>(args)...);
+}
+
 template <typename K, typename V, typename Set, typename... Types>
 inline auto make_unordered_map(Types&&... args)
 {
@@ -217,6 +345,12 @@ inline auto make_unordered_map(shared<Set>& shared, Types&&... args)
 	return cntr::make_unordered_map<K, V, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename K, typename V, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unordered_map(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_unordered_map<K, V>(frame, std::forward<Types>(args)...);
+}
+
 template <typename Set, typename... Types>
 inline auto make_string(Types&&... args)
 {
@@ -229,6 +363,12 @@ inline auto make_string(shared<Set>& shared, Types&&... args)
 	return cntr::make_string<Set>(shared, std::forward<Types>(args)...);
 }
 
+template <cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_string(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_string(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_unique(Types&&... args)
 {
@@ -241,6 +381,12 @@ inline auto make_unique(shared<Set>& shared, Types&&... args)
 	return cntr::make_unique<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_unique(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_unique<T>(frame, std::forward<Types>(args)...);
+}
+
 template <typename T, typename Set, typename... Types>
 inline auto make_shared(Types&&... args)
 {
@@ -253,6 +399,12 @@ inline auto make_shared(shared<Set>& shared, Types&&... args)
 	return cntr::make_shared<T, Set>(shared, std::forward<Types>(args)...);
 }
 
+template <typename T, cfg::FrameOptions Options, cfg::SharedPolicy Policy, typename... Types>
+inline auto make_shared(core::FrameArena<Options, Policy>& frame, Types&&... args)
+{
+	return cntr::make_shared<T>(frame, std::forward<Types>(args)...);
+}
+
 
 #endif
 
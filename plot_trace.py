@@ -31,10 +31,30 @@ if not csv_files:
 	sys.exit(1)
 
 trace_data = {}
+frame_data = {}
 
 for path in csv_files:
 	with open(path, newline='') as csvfile:
 		reader = csv.DictReader(csvfile)
+
+		# frame streams from trace_frames_open / trace_frame_mark
+
+		if reader.fieldnames and "frame" in reader.fieldnames:
+			for row in reader:
+				try:
+					frame = int(row["frame"])
+					stride = int(row["stride"])
+					block_count = int(row["block_count"])
+					in_use = int(row["in_use"])
+					frame_fallbacks = int(row["fallbacks"])
+					exhaustions = int(row["exhaustions"])
+				except ValueError:
+					continue
+
+				series = frame_data.setdefault(stride, {"block_count": block_count, "frames": {}})
+				series["frames"][frame] = (in_use, frame_fallbacks, exhaustions)
+			continue
+
 		phase_total = {}
 		for row in reader:
 			try:
@@ -67,10 +87,81 @@ for path in csv_files:
 		for key, total in phase_total.items():
 			trace_data[key]["peak"] = max(trace_data[key]["peak"], total)
 
-if not trace_data:
+if not trace_data and not frame_data:
 	print("error: no allocation data found in trace files")
 	sys.exit(1)
 
+
+def plot_frames():
+	frame_count = 1 + max(f for series in frame_data.values() for f in series["frames"])
+	frames = range(frame_count)
+
+	# cumulative counters are turned into per-frame deltas, frames a stride was not reported in repeat the last value
+
+	utilization = {}
+	fallback_deltas = [0] * frame_count
+	exhaustion_deltas = {}
+
+	for stride, series in frame_data.items():
+		last = (0, 0, 0)
+		usage = []
+		spikes = []
+		for frame in frames:
+			current = series["frames"].get(frame, last)
+			usage.append(current[0] / max(series["block_count"], 1))
+			fallback_deltas[frame] += current[1] - last[1]
+			spikes.append(current[2] - last[2])
+			last = current
+		utilization[stride] = usage
+		exhaustion_deltas[stride] = spikes
+
+	hottest = sorted(utilization, key=lambda s: max(utilization[s]), reverse=True)[:8]
+
+	fig, (ax1, ax2, ax3) = plt.subplots(3, 1, figsize=(12, 10), sharex=True)
+
+	for stride in sorted(hottest):
+		ax1.plot(frames, utilization[stride], linewidth=1.2, label=f"{stride} B")
+	ax1.set_ylabel("STRIDE UTILIZATION", fontsize=10)
+	ax1.legend(loc="upper left", fontsize=8, ncol=4)
+
+	ax2.bar(frames, fallback_deltas, width=1, color='none', edgecolor='white', hatch='//', linewidth=1.2)
+	ax2.set_ylabel("FALLBACKS PER FRAME", fontsize=10)
+
+	exhausted = [s for s in sorted(exhaustion_deltas) if any(exhaustion_deltas[s])]
+	for stride in exhausted:
+		hits = [f for f in frames if exhaustion_deltas[stride][f] > 0]
+		ax3.scatter(hits, [stride] * len(hits), marker='x', color='white')
+	ax3.set_ylabel("EXHAUSTED STRIDE", fontsize=10)
+	ax3.set_yscale("log", base=2)
+
+	for ax in (ax1, ax2, ax3):
+		ax.grid(True, axis='y', linestyle='--', alpha=0.4)
+		ax.tick_params(axis='x', colors='white')
+		ax.tick_params(axis='y', colors='white')
+		ax.yaxis.label.set_color('white')
+
+	ax3.set_xlabel("FRAME", fontsize=10)
+
+	plt.suptitle("POOL PRESSURE OVER TIME: PER-FRAME STRIDE SIGNATURE", color='white', fontsize=12)
+	plt.tight_layout(pad=1.5, h_pad=1.0)
+
+	svg_path = os.path.join(trace_dir, "alloc_frames.svg")
+	plt.savefig(svg_path, format="svg")
+
+	print(f"\nmetapool frame trace: {frame_count} frames, {len(frame_data)} strides\n")
+
+	for stride in exhausted:
+		hits = [f"{f} (+{exhaustion_deltas[stride][f]})" for f in frames if exhaustion_deltas[stride][f] > 0]
+		print(f"stride {stride:>10} exhausted in frames: {', '.join(hits[:16])}{' ...' if len(hits) > 16 else ''}")
+
+
+if frame_data:
+	plot_frames()
+
+if not trace_data:
+	plt.show()
+	sys.exit(0)
+
 active_keys = sorted(trace_data.keys(), key=lambda x: x[0])
 raw_sizes = sorted(set(k[0] for k in active_keys))
 indices = range(len(raw_sizes))